@@ -1,10 +1,38 @@
+# also writes `<output_name>.meta` with the shader's resource counts and
+# vertex inputs into the build directory, see tools/shader_reflect
+#
+# with EMBED, `<output_name>.hpp` is generated into the build directory as
+# well, add CMAKE_CURRENT_BINARY_DIR to the target's include directories. It
+# holds the SPIR-V and the meta text as constexpr arrays named after the
+# output, e.g. `vert_spv` and `vert_spv_meta`, so the shader is loaded
+# without file I/O.
+set(EMBED_SHADER_SCRIPT ${CMAKE_CURRENT_LIST_DIR}/embed_shader.cmake)
+
 macro(compile_shader shader_name output_name)
+    cmake_parse_arguments(COMPILE_SHADER "EMBED" "" "" ${ARGN})
     if (GLSLC_PROG)
+        set(compile_shader_outputs ${CMAKE_CURRENT_SOURCE_DIR}/${output_name} ${CMAKE_CURRENT_BINARY_DIR}/${output_name}.meta)
+        set(compile_shader_embed_command)
+        if (COMPILE_SHADER_EMBED)
+            string(MAKE_C_IDENTIFIER ${output_name} compile_shader_symbol)
+            list(APPEND compile_shader_outputs ${CMAKE_CURRENT_BINARY_DIR}/${output_name}.hpp)
+            set(compile_shader_embed_command
+                COMMAND ${CMAKE_COMMAND}
+                    -DSHADER_NAME=${shader_name}
+                    -DSPIRV_FILE=${CMAKE_CURRENT_SOURCE_DIR}/${output_name}
+                    -DMETA_FILE=${CMAKE_CURRENT_BINARY_DIR}/${output_name}.meta
+                    -DHEADER_FILE=${CMAKE_CURRENT_BINARY_DIR}/${output_name}.hpp
+                    -DSYMBOL=${compile_shader_symbol}
+                    -P ${EMBED_SHADER_SCRIPT})
+        endif()
         add_custom_command(
-            OUTPUT ${CMAKE_CURRENT_SOURCE_DIR}/${output_name}
+            OUTPUT ${compile_shader_outputs}
             COMMAND ${GLSLC_PROG}  ${CMAKE_CURRENT_SOURCE_DIR}/${shader_name} -o ${CMAKE_CURRENT_SOURCE_DIR}/${output_name}
+            COMMAND shader_reflect ${CMAKE_CURRENT_SOURCE_DIR}/${output_name} ${CMAKE_CURRENT_BINARY_DIR}/${output_name}.meta
+            ${compile_shader_embed_command}
             COMMENT "compiling shader ${CMAKE_CURRENT_SOURCE_DIR}/${shader_name} -> ${output_name}"
             MAIN_DEPENDENCY ${CMAKE_CURRENT_SOURCE_DIR}/${shader_name}
+            DEPENDS shader_reflect ${EMBED_SHADER_SCRIPT}
             WORKING_DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR}
             VERBATIM
         )
@@ -0,0 +1,17 @@
+# the cooked texture is written into the build directory, `output_name` is
+# relative to CMAKE_CURRENT_BINARY_DIR
+#
+# extra arguments are passed to texture_cooker, e.g. `--format bc7`
+macro(cook_texture image_name output_name)
+    get_filename_component(cook_texture_dir ${CMAKE_CURRENT_BINARY_DIR}/${output_name} DIRECTORY)
+    add_custom_command(
+        OUTPUT ${CMAKE_CURRENT_BINARY_DIR}/${output_name}
+        COMMAND ${CMAKE_COMMAND} -E make_directory ${cook_texture_dir}
+        COMMAND texture_cooker ${ARGN} ${CMAKE_CURRENT_SOURCE_DIR}/${image_name} ${CMAKE_CURRENT_BINARY_DIR}/${output_name}
+        COMMENT "cooking texture ${CMAKE_CURRENT_SOURCE_DIR}/${image_name} -> ${output_name}"
+        MAIN_DEPENDENCY ${CMAKE_CURRENT_SOURCE_DIR}/${image_name}
+        DEPENDS texture_cooker
+        WORKING_DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR}
+        VERBATIM
+    )
+endmacro()
@@ -0,0 +1,22 @@
+# run by compile_shader(... EMBED) in script mode:
+#   cmake -DSHADER_NAME=... -DSPIRV_FILE=... -DMETA_FILE=... -DHEADER_FILE=...
+#         -DSYMBOL=... -P embed_shader.cmake
+file(READ ${SPIRV_FILE} spirv_hex HEX)
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," spirv_bytes "${spirv_hex}")
+# 16 bytes per line, CMake regexes have no {n}
+string(REPEAT "0x..," 16 line_regex)
+string(REGEX REPLACE "(${line_regex})" "\\1\n    " spirv_bytes "${spirv_bytes}")
+file(READ ${META_FILE} meta_text)
+
+file(WRITE ${HEADER_FILE}
+"// generated by compile_shader() from ${SHADER_NAME}, don't edit
+#pragma once
+#include <cstdint>
+
+// SPIR-V is consumed as 32 bit words
+alignas(4) constexpr uint8_t ${SYMBOL}[] = {
+    ${spirv_bytes}
+};
+
+constexpr char ${SYMBOL}_meta[] = R\"meta(${meta_text})meta\";
+")
@@ -10,5 +10,6 @@ layout(location = 1) out vec2 fragUV;
 void main() {
     gl_Position = vec4(inPosition, 0.0, 1.0);
     fragColor = inColor;
-    fragUV = inUV;
+    // flip v, images are top row first
+    fragUV = vec2(inUV.x, 1.0 - inUV.y);
 }
\ No newline at end of file
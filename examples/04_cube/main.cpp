@@ -298,7 +298,6 @@ void createAndUploadVertexData() {
 
 void createImageTexture() {
     int w, h;
-    stbi_set_flip_vertically_on_load(true);
     unsigned char* data =
         stbi_load("examples/03_texture/girl.png", &w, &h, NULL, STBI_rgb_alpha);
 
@@ -313,15 +312,23 @@ void createImageTexture() {
     memcpy(ptr, data, image_size);
     SDL_UnmapGPUTransferBuffer(gDevice, transfer_buffer);
 
+    // full mip chain down to 1x1
+    Uint32 num_levels = 1;
+    for (int size = SDL_max(w, h); size > 1; size >>= 1) {
+        num_levels++;
+    }
+
     SDL_GPUTextureCreateInfo texture_ci;
     texture_ci.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
     texture_ci.height = h;
     texture_ci.width = w;
     texture_ci.layer_count_or_depth = 1;
-    texture_ci.num_levels = 1;
+    texture_ci.num_levels = num_levels;
     texture_ci.sample_count = SDL_GPU_SAMPLECOUNT_1;
     texture_ci.type = SDL_GPU_TEXTURETYPE_2D;
-    texture_ci.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
+    // generating mipmaps renders into the texture
+    texture_ci.usage =
+        SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COLOR_TARGET;
 
     gTexture = SDL_CreateGPUTexture(gDevice, &texture_ci);
 
@@ -348,6 +355,11 @@ void createImageTexture() {
     SDL_UploadToGPUTexture(copy_pass, &transfer_info, &region, false);
     SDL_EndGPUCopyPass(copy_pass);
 
+    // fill the other levels from level 0
+    if (texture_ci.num_levels > 1) {
+        SDL_GenerateMipmapsForGPUTexture(cmd, gTexture);
+    }
+
     SDL_SubmitGPUCommandBuffer(cmd);
 
     SDL_ReleaseGPUTransferBuffer(gDevice, transfer_buffer);
@@ -379,8 +391,9 @@ void createSampler() {
     ci.enable_compare = false;
     ci.mag_filter = SDL_GPU_FILTER_LINEAR;
     ci.min_filter = SDL_GPU_FILTER_LINEAR;
-    ci.max_lod = 1.0;
-    ci.min_lod = 1.0;
+    // use the whole mip chain
+    ci.max_lod = 1000.0;
+    ci.min_lod = 0.0;
     ci.mip_lod_bias = 0.0;
     ci.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR;
 
@@ -12,5 +12,6 @@ layout(set = 1, binding = 0) uniform MVP {
 
 void main() {
     gl_Position = mvp.proj * mvp.model * vec4(inPosition, 1.0);
-    fragUV = inUV;
+    // flip v, images are top row first
+    fragUV = vec2(inUV.x, 1.0 - inUV.y);
 }
\ No newline at end of file
@@ -0,0 +1,197 @@
+#include "asset_reader.hpp"
+
+// how often a job checks whether the storage became ready
+constexpr Sint32 StorageReadyPollMS = 1;
+
+bool AssetReader::Init(const char* root) {
+    storage = SDL_OpenFileStorage(root);
+    if (!storage) {
+        SDL_LogError(SDL_LOG_CATEGORY_SYSTEM, "open storage %s failed: %s",
+                     root ? root : ".", SDL_GetError());
+        return false;
+    }
+
+    mutex = SDL_CreateMutex();
+    jobAvailable = SDL_CreateCondition();
+    if (!mutex || !jobAvailable) {
+        SDL_LogError(SDL_LOG_CATEGORY_SYSTEM,
+                     "create asset reader sync objects failed: %s",
+                     SDL_GetError());
+        return false;
+    }
+
+    thread = SDL_CreateThread(WorkerMain, "asset reader", this);
+    if (!thread) {
+        SDL_LogError(SDL_LOG_CATEGORY_SYSTEM,
+                     "create asset reader thread failed: %s", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+void AssetReader::Destroy() {
+    if (mutex) {
+        SDL_LockMutex(mutex);
+        quit = true;
+        SDL_BroadcastCondition(jobAvailable);
+        SDL_UnlockMutex(mutex);
+    }
+    if (thread) {
+        SDL_WaitThread(thread, nullptr);
+        thread = nullptr;
+    }
+
+    // no callback ran for these, so their allocated memory goes back
+    // through the cancel callbacks
+    for (auto& job : finished) {
+        if (job.ownsData) {
+            SDL_free(job.data);
+        }
+        if (job.cancel) {
+            job.cancel();
+        }
+    }
+    for (auto& job : jobs) {
+        if (job.cancel) {
+            job.cancel();
+        }
+    }
+    finished.clear();
+    jobs.clear();
+    outstanding = 0;
+
+    if (storage) {
+        SDL_CloseStorage(storage);
+    }
+    SDL_DestroyCondition(jobAvailable);
+    SDL_DestroyMutex(mutex);
+    storage = nullptr;
+    jobAvailable = nullptr;
+    mutex = nullptr;
+}
+
+void AssetReader::Read(const char* path, ReadCallback callback) {
+    Read(path, {}, std::move(callback));
+}
+
+void AssetReader::Read(const char* path, AllocateCallback allocate,
+                       ReadCallback callback, CancelCallback cancel) {
+    Job job;
+    job.path = path;
+    job.allocate = std::move(allocate);
+    job.callback = std::move(callback);
+    job.cancel = std::move(cancel);
+
+    outstanding++;
+    Push(std::move(job));
+}
+
+int AssetReader::Poll() {
+    std::vector<Job> done;
+    SDL_LockMutex(mutex);
+    done.swap(finished);
+    SDL_UnlockMutex(mutex);
+
+    int finished_num = 0;
+    for (auto& job : done) {
+        if (job.stage == JobStage::Read) {
+            // the worker reads into the heap when this returned nullptr
+            job.data = job.allocate(job.size);
+            job.allocate = nullptr;
+            Push(std::move(job));
+            continue;
+        }
+
+        job.callback(job.path.c_str(), job.data, job.size);
+        if (job.ownsData) {
+            SDL_free(job.data);
+        }
+        finished_num++;
+    }
+    outstanding -= finished_num;
+    return finished_num;
+}
+
+void AssetReader::Push(Job&& job) {
+    SDL_LockMutex(mutex);
+    jobs.push_back(std::move(job));
+    SDL_SignalCondition(jobAvailable);
+    SDL_UnlockMutex(mutex);
+}
+
+int SDLCALL AssetReader::WorkerMain(void* userdata) {
+    auto reader = static_cast<AssetReader*>(userdata);
+
+    SDL_LockMutex(reader->mutex);
+    while (true) {
+        while (reader->jobs.empty() && !reader->quit) {
+            SDL_WaitCondition(reader->jobAvailable, reader->mutex);
+        }
+        if (reader->quit) {
+            break;
+        }
+        // SDL has no notification for this, so only a pending job polls for
+        // it, on this thread instead of the main thread. File storage is
+        // ready right away.
+        if (!SDL_StorageReady(reader->storage)) {
+            SDL_WaitConditionTimeout(reader->jobAvailable, reader->mutex,
+                                     StorageReadyPollMS);
+            continue;
+        }
+
+        Job job = std::move(reader->jobs.front());
+        reader->jobs.pop_front();
+        SDL_UnlockMutex(reader->mutex);
+
+        if (job.stage == JobStage::Size) {
+            reader->Size(job);
+        }
+        // with a pending allocate callback wait for `Poll()` to provide data
+        if (job.stage == JobStage::Read && !job.allocate) {
+            reader->ReadData(job);
+        }
+
+        SDL_LockMutex(reader->mutex);
+        reader->finished.push_back(std::move(job));
+    }
+    SDL_UnlockMutex(reader->mutex);
+    return 0;
+}
+
+void AssetReader::Size(Job& job) {
+    job.stage = JobStage::Finished;
+
+    if (!SDL_GetStorageFileSize(storage, job.path.c_str(), &job.size)) {
+        SDL_LogError(SDL_LOG_CATEGORY_SYSTEM, "get file %s size failed: %s",
+                     job.path.c_str(), SDL_GetError());
+        return;
+    }
+    job.stage = JobStage::Read;
+}
+
+void AssetReader::ReadData(Job& job) {
+    job.stage = JobStage::Finished;
+
+    if (!job.data) {
+        job.data = SDL_malloc(job.size);
+        if (!job.data) {
+            SDL_LogError(SDL_LOG_CATEGORY_SYSTEM,
+                         "allocate %llu bytes for %s failed",
+                         (unsigned long long)job.size, job.path.c_str());
+            return;
+        }
+        job.ownsData = true;
+    }
+
+    if (!SDL_ReadStorageFile(storage, job.path.c_str(), job.data, job.size)) {
+        SDL_LogError(SDL_LOG_CATEGORY_SYSTEM, "read file %s failed: %s",
+                     job.path.c_str(), SDL_GetError());
+        if (job.ownsData) {
+            SDL_free(job.data);
+            job.ownsData = false;
+        }
+        // caller provided memory stays the caller's, it sees the failure
+        // through the nullptr
+        job.data = nullptr;
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "SDL3/SDL.h"
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Reads whole files from an SDL_Storage on a worker thread. All reads are
+// issued up front and finish on the thread calling `Poll()`, which is where
+// GPU objects are made, so creating them overlaps with the reads still in
+// flight. The main thread never waits for the storage to become ready.
+struct AssetReader {
+    // `data` is nullptr when the read failed. It points into the memory the
+    // allocate callback returned, otherwise into a heap buffer that is freed
+    // after the callback.
+    using ReadCallback =
+        std::function<void(const char* path, void* data, Uint64 size)>;
+    // returns `size` bytes to read into (e.g. a mapped transfer buffer), or
+    // nullptr to read into the heap
+    using AllocateCallback = std::function<void*(Uint64 size)>;
+    // gives back what the allocate callback returned, for files that never
+    // finished
+    using CancelCallback = std::function<void()>;
+
+    // paths are relative to `root`, or to the working directory without one
+    bool Init(const char* root);
+    // calls the cancel callbacks of unfinished files
+    void Destroy();
+
+    void Read(const char* path, ReadCallback callback);
+
+    // read straight into caller provided memory. The worker looks the size
+    // up first, then `allocate` is called from `Poll()` and the file is read
+    // into the returned memory on the worker again. `cancel` is called by
+    // `Destroy()` instead of `callback` if the file didn't finish.
+    void Read(const char* path, AllocateCallback allocate,
+              ReadCallback callback, CancelCallback cancel = {});
+
+    // call the allocate callbacks of sized files and the read callbacks of
+    // finished files, returns how many files finished
+    int Poll();
+
+    bool IsIdle() const { return outstanding == 0; }
+
+private:
+    enum class JobStage {
+        // look up the size, and without an allocate callback read too
+        Size,
+        // read into `data`, once `Poll()` provided it
+        Read,
+        Finished,
+    };
+
+    struct Job {
+        std::string path;
+        AllocateCallback allocate;
+        ReadCallback callback;
+        CancelCallback cancel;
+        JobStage stage = JobStage::Size;
+        void* data{};
+        Uint64 size{};
+        // `data` was allocated here, not by the allocate callback
+        bool ownsData = false;
+    };
+
+    static int SDLCALL WorkerMain(void* userdata);
+    void Size(Job& job);
+    void ReadData(Job& job);
+    void Push(Job&& job);
+
+    SDL_Storage* storage{};
+    SDL_Mutex* mutex{};
+    SDL_Condition* jobAvailable{};
+    SDL_Thread* thread{};
+    std::deque<Job> jobs;
+    // jobs the worker is done with, either finished or waiting for `data`
+    std::vector<Job> finished;
+    bool quit = false;
+    int outstanding = 0;
+};
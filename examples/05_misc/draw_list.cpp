@@ -0,0 +1,62 @@
+#include "draw_list.hpp"
+
+// the bits of non-negative floats sort like the floats themselves
+static Uint32 depthBits(float depth) {
+    depth = SDL_max(depth, 0.0f);
+    Uint32 bits;
+    SDL_memcpy(&bits, &depth, sizeof(bits));
+    return bits;
+}
+
+Uint64 makeOpaqueDrawKey(Uint32 pipeline, Uint32 texture, float depth) {
+    return (Uint64(pipeline & 0x7F) << 56) | (Uint64(texture & 0xFFFF) << 40) |
+           (Uint64(depthBits(depth)) << 8);
+}
+
+Uint64 makeTransparentDrawKey(Uint32 pipeline, Uint32 texture, float depth) {
+    return (Uint64(1) << 63) | (Uint64(~depthBits(depth)) << 31) |
+           (Uint64(pipeline & 0x7F) << 24) | (Uint64(texture & 0xFFFF) << 8);
+}
+
+void radixSortDrawItems(std::vector<DrawItem>& items,
+                        std::vector<DrawItem>& scratch) {
+    size_t count = items.size();
+    if (count < 2) {
+        return;
+    }
+    scratch.resize(count);
+
+    // all histograms in one read over the keys
+    Uint32 histograms[8][256] = {};
+    for (auto& item : items) {
+        for (int pass = 0; pass < 8; pass++) {
+            histograms[pass][(item.key >> (pass * 8)) & 0xFF]++;
+        }
+    }
+
+    DrawItem* src = items.data();
+    DrawItem* dst = scratch.data();
+    for (int pass = 0; pass < 8; pass++) {
+        Uint32* histogram = histograms[pass];
+        if (histogram[(src[0].key >> (pass * 8)) & 0xFF] == count) {
+            continue;
+        }
+
+        Uint32 offset = 0;
+        for (int digit = 0; digit < 256; digit++) {
+            Uint32 digit_count = histogram[digit];
+            histogram[digit] = offset;
+            offset += digit_count;
+        }
+        for (size_t i = 0; i < count; i++) {
+            dst[histogram[(src[i].key >> (pass * 8)) & 0xFF]++] = src[i];
+        }
+        DrawItem* tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != items.data()) {
+        items.swap(scratch);
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include "SDL3/SDL.h"
+#include <vector>
+
+// One draw in sort order, `index` points back to the drawn object.
+struct DrawItem {
+    Uint64 key;
+    Uint32 index;
+};
+
+// Sort keys, sorting ascending gives the submission order.
+//
+// opaque:      | pass 0 (1) | pipeline (7) | texture (16) | depth (32) |
+// transparent: | pass 1 (1) | ~depth (32)  | pipeline (7) | texture (16) |
+//
+// Opaque draws are grouped by state and go front to back inside a group,
+// so early depth testing rejects hidden fragments. Transparent draws come
+// after all opaque ones and go strictly back to front, so blending is
+// correct. `depth` is the view space distance, negative values clamp to 0.
+Uint64 makeOpaqueDrawKey(Uint32 pipeline, Uint32 texture, float depth);
+Uint64 makeTransparentDrawKey(Uint32 pipeline, Uint32 texture, float depth);
+
+// LSD radix sort on the keys, 8 bits per pass. Passes whose digit is the
+// same for every key are skipped. Stable, `scratch` is resized as needed.
+void radixSortDrawItems(std::vector<DrawItem>& items,
+                        std::vector<DrawItem>& scratch);
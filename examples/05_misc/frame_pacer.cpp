@@ -0,0 +1,140 @@
+#include "frame_pacer.hpp"
+
+bool FramePacer::Init(SDL_GPUDevice* device, SDL_Window* window,
+                      Uint32 frames_in_flight, bool blocking) {
+    this->device = device;
+    this->window = window;
+    this->blocking = blocking;
+
+    frames_in_flight = SDL_clamp(frames_in_flight, 1u, 3u);
+    framesInFlight = frames_in_flight;
+    if (!SDL_SetGPUAllowedFramesInFlight(device, frames_in_flight)) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU, "set frames in flight failed: %s",
+                     SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+void FramePacer::Destroy() {
+    if (!fences.empty()) {
+        SDL_WaitForGPUFences(device, true, fences.data(),
+                             static_cast<Uint32>(fences.size()));
+    }
+    for (auto fence : fences) {
+        SDL_ReleaseGPUFence(device, fence);
+    }
+    fences.clear();
+}
+
+bool FramePacer::SetPresentMode(SDL_GPUPresentMode mode) {
+    if (!window) {
+        return true;
+    }
+    if (!SDL_WindowSupportsGPUPresentMode(device, window, mode)) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_GPU,
+                    "present mode %d is not supported, using vsync", mode);
+        mode = SDL_GPU_PRESENTMODE_VSYNC;
+    }
+    if (!SDL_SetGPUSwapchainParameters(device, window,
+                                       SDL_GPU_SWAPCHAINCOMPOSITION_SDR,
+                                       mode)) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU,
+                     "set swapchain parameters failed: %s", SDL_GetError());
+        return false;
+    }
+    presentMode = mode;
+    return true;
+}
+
+bool FramePacer::BeginFrame(SDL_GPUCommandBuffer** out_cmd,
+                            SDL_GPUTexture** out_swapchain,
+                            Uint32* out_width, Uint32* out_height) {
+    PollFences();
+
+    if (!window) {
+        if (fences.size() >= framesInFlight) {
+            if (!blocking) {
+                stats.skipped++;
+                return false;
+            }
+            Uint64 wait_begin = SDL_GetTicksNS();
+            SDL_WaitForGPUFences(device, true, fences.data(), 1);
+            stats.cpuWaitNS += SDL_GetTicksNS() - wait_begin;
+            PollFences();
+        }
+
+        *out_cmd = SDL_AcquireGPUCommandBuffer(device);
+        if (!*out_cmd) {
+            SDL_LogError(SDL_LOG_CATEGORY_GPU,
+                         "acquire command buffer failed: %s", SDL_GetError());
+            return false;
+        }
+        *out_swapchain = nullptr;
+        return true;
+    }
+
+    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer(device);
+    if (!cmd) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU, "acquire command buffer failed: %s",
+                     SDL_GetError());
+        return false;
+    }
+
+    SDL_GPUTexture* swapchain = nullptr;
+    Uint64 wait_begin = SDL_GetTicksNS();
+    bool ok = blocking ? SDL_WaitAndAcquireGPUSwapchainTexture(
+                             cmd, window, &swapchain, out_width, out_height)
+                       : SDL_AcquireGPUSwapchainTexture(
+                             cmd, window, &swapchain, out_width, out_height);
+    stats.cpuWaitNS += SDL_GetTicksNS() - wait_begin;
+    if (!ok) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU,
+                     "SDL swapchain texture acquire failed! %s",
+                     SDL_GetError());
+    }
+
+    if (!swapchain) {
+        // no swapchain image was acquired, so the command buffer can be
+        // dropped without presenting anything
+        SDL_CancelGPUCommandBuffer(cmd);
+        stats.skipped++;
+        return false;
+    }
+
+    *out_cmd = cmd;
+    *out_swapchain = swapchain;
+    return true;
+}
+
+bool FramePacer::EndFrame(SDL_GPUCommandBuffer* cmd) {
+    SDL_GPUFence* fence = SDL_SubmitGPUCommandBufferAndAcquireFence(cmd);
+    if (!fence) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU,
+                     "SDL submit command buffer failed! %s", SDL_GetError());
+        return false;
+    }
+    fences.push_back(fence);
+
+    if (idleSince) {
+        stats.gpuIdleNS += SDL_GetTicksNS() - idleSince;
+        idleSince = 0;
+    }
+    stats.frames++;
+    return true;
+}
+
+void FramePacer::PollFences() {
+    // frames finish in submission order
+    size_t done = 0;
+    while (done < fences.size() && SDL_QueryGPUFence(device, fences[done])) {
+        SDL_ReleaseGPUFence(device, fences[done]);
+        done++;
+    }
+    fences.erase(fences.begin(), fences.begin() + done);
+
+    // the GPU ran out of work somewhere since the last poll
+    if (done > 0 && fences.empty()) {
+        idleSince = SDL_GetTicksNS();
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "SDL3/SDL.h"
+#include <vector>
+
+// Starts and submits frames, limiting how many of them the GPU may queue.
+//
+// In blocking mode the swapchain image is acquired with
+// SDL_WaitAndAcquireGPUSwapchainTexture, like the other examples do. Without
+// it SDL_AcquireGPUSwapchainTexture is used, which returns no image while the
+// GPU is still busy with `framesInFlight` frames, so the caller can keep
+// simulating and try again on the next iteration instead of sleeping.
+//
+// Without a window nothing is presented and BeginFrame hands out no swapchain
+// image, the frames in flight limit is then enforced with the fences alone.
+//
+// Two times are accumulated to tell who waits for whom:
+// - cpu wait: the main thread blocked in the acquire, the GPU is the
+//   bottleneck
+// - gpu idle: every submitted frame had finished before the next one was
+//   submitted, the CPU is the bottleneck. Fences are only polled when a frame
+//   begins, so this is a lower bound.
+struct FramePacer {
+    struct Stats {
+        Uint64 frames{};
+        // iterations that found no free swapchain image
+        Uint64 skipped{};
+        Uint64 cpuWaitNS{};
+        Uint64 gpuIdleNS{};
+    };
+
+    // `frames_in_flight` is clamped to the 1..3 frames SDL supports
+    bool Init(SDL_GPUDevice* device, SDL_Window* window,
+              Uint32 frames_in_flight, bool blocking);
+    void Destroy();
+
+    // switches the swapchain to `mode`, falling back to VSYNC (which every
+    // driver supports) when the window can't present that way
+    bool SetPresentMode(SDL_GPUPresentMode mode);
+    SDL_GPUPresentMode GetPresentMode() const { return presentMode; }
+
+    // acquires a command buffer and the swapchain image. Returns false when
+    // there is nothing to render to, nothing has to be submitted then.
+    // Without a window the swapchain image is null and the size untouched.
+    bool BeginFrame(SDL_GPUCommandBuffer** out_cmd,
+                    SDL_GPUTexture** out_swapchain, Uint32* out_width,
+                    Uint32* out_height);
+    bool EndFrame(SDL_GPUCommandBuffer* cmd);
+
+    const Stats& GetStats() const { return stats; }
+    void ResetStats() { stats = {}; }
+
+private:
+    void PollFences();
+
+    SDL_GPUDevice* device{};
+    SDL_Window* window{};
+    bool blocking{};
+    Uint32 framesInFlight{};
+    SDL_GPUPresentMode presentMode = SDL_GPU_PRESENTMODE_VSYNC;
+    // one per submitted frame the GPU hasn't finished yet
+    std::vector<SDL_GPUFence*> fences;
+    // when PollFences first saw the GPU without work, 0 while it has some
+    Uint64 idleSince{};
+    Stats stats;
+};
@@ -0,0 +1,94 @@
+#include "frustum_culling.hpp"
+
+Frustum extractFrustum(const glm::mat4& view_proj) {
+    // rows of the matrix, glm stores columns
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++) {
+        rows[i] = glm::vec4(view_proj[0][i], view_proj[1][i], view_proj[2][i],
+                            view_proj[3][i]);
+    }
+
+    // the planes don't need normalizing, the box test scales with them
+    Frustum frustum;
+    frustum.planes[0] = rows[3] + rows[0];  // left
+    frustum.planes[1] = rows[3] - rows[0];  // right
+    frustum.planes[2] = rows[3] + rows[1];  // bottom
+    frustum.planes[3] = rows[3] - rows[1];  // top
+    frustum.planes[4] = rows[3] + rows[2];  // near
+    frustum.planes[5] = rows[3] - rows[2];  // far
+    return frustum;
+}
+
+// a box is outside when it is completely behind one plane: the distance of
+// its center is below minus its extents projected onto the plane normal
+static bool isBoxVisible(const Frustum& frustum,
+                         const TransformStore::WorldBounds& bounds, size_t i) {
+    for (auto& plane : frustum.planes) {
+        float d = plane.x * bounds.centerX[i] + plane.y * bounds.centerY[i] +
+                  plane.z * bounds.centerZ[i] + plane.w;
+        float r = SDL_fabsf(plane.x) * bounds.extentX[i] +
+                  SDL_fabsf(plane.y) * bounds.extentY[i] +
+                  SDL_fabsf(plane.z) * bounds.extentZ[i];
+        if (d + r < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void cullBounds(const Frustum& frustum,
+                const TransformStore::WorldBounds& bounds, size_t count,
+                std::vector<Uint32>& visible) {
+    size_t i = 0;
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+    __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 plane_x[6], plane_y[6], plane_z[6], plane_w[6];
+    __m128 plane_abs_x[6], plane_abs_y[6], plane_abs_z[6];
+    for (int p = 0; p < 6; p++) {
+        plane_x[p] = _mm_set1_ps(frustum.planes[p].x);
+        plane_y[p] = _mm_set1_ps(frustum.planes[p].y);
+        plane_z[p] = _mm_set1_ps(frustum.planes[p].z);
+        plane_w[p] = _mm_set1_ps(frustum.planes[p].w);
+        plane_abs_x[p] = _mm_and_ps(plane_x[p], abs_mask);
+        plane_abs_y[p] = _mm_and_ps(plane_y[p], abs_mask);
+        plane_abs_z[p] = _mm_and_ps(plane_z[p], abs_mask);
+    }
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 cx = _mm_loadu_ps(&bounds.centerX[i]);
+        __m128 cy = _mm_loadu_ps(&bounds.centerY[i]);
+        __m128 cz = _mm_loadu_ps(&bounds.centerZ[i]);
+        __m128 ex = _mm_loadu_ps(&bounds.extentX[i]);
+        __m128 ey = _mm_loadu_ps(&bounds.extentY[i]);
+        __m128 ez = _mm_loadu_ps(&bounds.extentZ[i]);
+
+        // lanes of boxes outside of any plane
+        __m128 outside = _mm_setzero_ps();
+        for (int p = 0; p < 6; p++) {
+            __m128 d = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(plane_x[p], cx), _mm_mul_ps(plane_y[p], cy)),
+                _mm_add_ps(_mm_mul_ps(plane_z[p], cz), plane_w[p]));
+            __m128 r = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(plane_abs_x[p], ex),
+                           _mm_mul_ps(plane_abs_y[p], ey)),
+                _mm_mul_ps(plane_abs_z[p], ez));
+            outside = _mm_or_ps(
+                outside, _mm_cmplt_ps(_mm_add_ps(d, r), _mm_setzero_ps()));
+        }
+
+        int mask = ~_mm_movemask_ps(outside) & 0xF;
+        for (int lane = 0; lane < 4; lane++) {
+            if (mask & (1 << lane)) {
+                visible.push_back(static_cast<Uint32>(i + lane));
+            }
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        if (isBoxVisible(frustum, bounds, i)) {
+            visible.push_back(static_cast<Uint32>(i));
+        }
+    }
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "SDL3/SDL.h"
+#include "transform_store.hpp"
+#include <vector>
+
+// planes point inwards, a point p is inside when dot(plane.xyz, p) + plane.w
+// >= 0 for all of them
+struct Frustum {
+    glm::vec4 planes[6];
+};
+
+// planes of the clip volume of `view_proj`, in world space
+Frustum extractFrustum(const glm::mat4& view_proj);
+
+// Appends the index of every box touching the frustum to `visible`, testing
+// 4 boxes per iteration with SSE. The test is conservative: boxes near the
+// frustum's corners may be kept although they are invisible.
+void cullBounds(const Frustum& frustum,
+                const TransformStore::WorldBounds& bounds, size_t count,
+                std::vector<Uint32>& visible);
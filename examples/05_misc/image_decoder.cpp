@@ -0,0 +1,209 @@
+#include "image_decoder.hpp"
+#include "stb_image.h"
+#include "stb_image_sink.h"
+
+bool ImageDecoder::Init(int thread_count) {
+    mutex = SDL_CreateMutex();
+    jobAvailable = SDL_CreateCondition();
+    if (!mutex || !jobAvailable) {
+        SDL_LogError(SDL_LOG_CATEGORY_SYSTEM,
+                     "create image decoder sync objects failed: %s",
+                     SDL_GetError());
+        return false;
+    }
+
+    for (int i = 0; i < thread_count; i++) {
+        SDL_Thread* thread =
+            SDL_CreateThread(WorkerMain, "image decoder", this);
+        if (!thread) {
+            SDL_LogError(SDL_LOG_CATEGORY_SYSTEM,
+                         "create image decoder thread failed: %s",
+                         SDL_GetError());
+            return false;
+        }
+        threads.push_back(thread);
+    }
+    return true;
+}
+
+void ImageDecoder::Destroy() {
+    if (mutex) {
+        SDL_LockMutex(mutex);
+        quit = true;
+        SDL_BroadcastCondition(jobAvailable);
+        SDL_UnlockMutex(mutex);
+    }
+
+    for (auto thread : threads) {
+        SDL_WaitThread(thread, nullptr);
+    }
+    threads.clear();
+
+    // no callback ran for these, so their allocated memory goes back
+    // through the cancel callbacks
+    for (auto& job : finished) {
+        if (job.image.pixels != job.dst) {
+            stbi_image_free(job.image.pixels);
+        }
+        SDL_free(job.fileData);
+        if (job.cancel) {
+            job.cancel();
+        }
+    }
+    for (auto& job : jobs) {
+        SDL_free(job.fileData);
+        if (job.cancel) {
+            job.cancel();
+        }
+    }
+    finished.clear();
+    jobs.clear();
+    outstanding = 0;
+
+    SDL_DestroyCondition(jobAvailable);
+    SDL_DestroyMutex(mutex);
+    jobAvailable = nullptr;
+    mutex = nullptr;
+}
+
+void ImageDecoder::Request(const char* filename, bool flip,
+                           DecodedCallback callback) {
+    Request(filename, flip, {}, std::move(callback));
+}
+
+void ImageDecoder::Request(const char* filename, bool flip,
+                           AllocateCallback allocate,
+                           DecodedCallback callback, CancelCallback cancel) {
+    Job job;
+    job.filename = filename;
+    job.image.filename = filename;
+    job.flip = flip;
+    job.allocate = std::move(allocate);
+    job.callback = std::move(callback);
+    job.cancel = std::move(cancel);
+
+    outstanding++;
+    Push(std::move(job));
+}
+
+int ImageDecoder::Poll() {
+    std::vector<Job> done;
+    SDL_LockMutex(mutex);
+    done.swap(finished);
+    SDL_UnlockMutex(mutex);
+
+    int finished_num = 0;
+    for (auto& job : done) {
+        if (job.stage == JobStage::Decode) {
+            job.dst = job.allocate(job.image.width, job.image.height);
+            // stb allocates the pixels when this returned nullptr
+            job.allocate = nullptr;
+            Push(std::move(job));
+            continue;
+        }
+
+        job.callback(job.image);
+        if (job.image.pixels != job.dst) {
+            stbi_image_free(job.image.pixels);
+        }
+        finished_num++;
+    }
+    outstanding -= finished_num;
+    return finished_num;
+}
+
+void ImageDecoder::Push(Job&& job) {
+    SDL_LockMutex(mutex);
+    jobs.push_back(std::move(job));
+    SDL_SignalCondition(jobAvailable);
+    SDL_UnlockMutex(mutex);
+}
+
+int SDLCALL ImageDecoder::WorkerMain(void* userdata) {
+    auto decoder = static_cast<ImageDecoder*>(userdata);
+
+    SDL_LockMutex(decoder->mutex);
+    while (true) {
+        while (decoder->jobs.empty() && !decoder->quit) {
+            SDL_WaitCondition(decoder->jobAvailable, decoder->mutex);
+        }
+        if (decoder->quit) {
+            break;
+        }
+
+        Job job = std::move(decoder->jobs.front());
+        decoder->jobs.pop_front();
+        SDL_UnlockMutex(decoder->mutex);
+
+        if (job.stage == JobStage::Read) {
+            decoder->Read(job);
+        }
+        // with a pending allocate callback wait for `Poll()` to provide dst
+        if (job.stage == JobStage::Decode && !job.allocate) {
+            decoder->Decode(job);
+        }
+
+        SDL_LockMutex(decoder->mutex);
+        decoder->finished.push_back(std::move(job));
+    }
+    SDL_UnlockMutex(decoder->mutex);
+    return 0;
+}
+
+void ImageDecoder::Read(Job& job) {
+    job.stage = JobStage::Finished;
+
+    job.fileData = SDL_LoadFile(job.filename.c_str(), &job.fileSize);
+    if (!job.fileData) {
+        SDL_LogError(SDL_LOG_CATEGORY_SYSTEM, "read image %s failed: %s",
+                     job.filename.c_str(), SDL_GetError());
+        return;
+    }
+
+    if (job.allocate &&
+        !stbi_info_from_memory(static_cast<stbi_uc*>(job.fileData),
+                               job.fileSize, &job.image.width,
+                               &job.image.height, nullptr)) {
+        SDL_LogError(SDL_LOG_CATEGORY_SYSTEM, "read image %s header failed: %s",
+                     job.filename.c_str(), stbi_failure_reason());
+        SDL_free(job.fileData);
+        job.fileData = nullptr;
+        return;
+    }
+
+    job.stage = JobStage::Decode;
+}
+
+void ImageDecoder::Decode(Job& job) {
+    job.stage = JobStage::Finished;
+
+    size_t size = 4 * (size_t)job.image.width * job.image.height;
+    if (job.dst) {
+        stbi_sink_begin(job.dst, size);
+    }
+
+    // flip flag is thread local, other workers may decode with another one
+    stbi_set_flip_vertically_on_load_thread(job.flip);
+    job.image.pixels = stbi_load_from_memory(
+        static_cast<stbi_uc*>(job.fileData), job.fileSize, &job.image.width,
+        &job.image.height, nullptr, STBI_rgb_alpha);
+
+    if (job.dst) {
+        stbi_sink_end();
+        if (job.image.pixels && job.image.pixels != job.dst) {
+            // this decoder converted the pixels once more after the sink
+            // allocation, so we pay one copy as before
+            memcpy(job.dst, job.image.pixels, size);
+            stbi_image_free(job.image.pixels);
+            job.image.pixels = static_cast<unsigned char*>(job.dst);
+        }
+    }
+
+    if (!job.image.pixels) {
+        SDL_LogError(SDL_LOG_CATEGORY_SYSTEM, "decode image %s failed: %s",
+                     job.filename.c_str(), stbi_failure_reason());
+    }
+
+    SDL_free(job.fileData);
+    job.fileData = nullptr;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "SDL3/SDL.h"
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct DecodedImage {
+    std::string filename;
+    int width = 0;
+    int height = 0;
+    // RGBA8, nullptr when decoding failed. Points into the memory returned
+    // by the allocate callback when one was given.
+    unsigned char* pixels{};
+};
+
+// Decodes images on a pool of worker threads. Finished images are handed
+// back on the thread calling `Poll()`, which is where GPU objects are made.
+struct ImageDecoder {
+    using DecodedCallback = std::function<void(DecodedImage&)>;
+    // returns `width * height * 4` bytes to decode into, or nullptr to let
+    // stb allocate the pixels
+    using AllocateCallback = std::function<void*(int width, int height)>;
+    // gives back what the allocate callback returned, for images that never
+    // finished
+    using CancelCallback = std::function<void()>;
+
+    bool Init(int thread_count);
+    // calls the cancel callbacks of unfinished images
+    void Destroy();
+
+    void Request(const char* filename, bool flip, DecodedCallback callback);
+
+    // Decode straight into caller provided memory (e.g. a mapped transfer
+    // buffer) instead of a temporary heap buffer. Workers read the image
+    // size first, then `allocate` is called from `Poll()`, and the pixels
+    // are decoded into the returned memory on a worker again. `cancel` is
+    // called by `Destroy()` instead of `callback` if the image didn't finish.
+    void Request(const char* filename, bool flip, AllocateCallback allocate,
+                 DecodedCallback callback, CancelCallback cancel = {});
+
+    // call the allocate callbacks of sized images and the decoded callbacks
+    // of finished images, returns how many images finished
+    int Poll();
+
+    bool IsIdle() const { return outstanding == 0; }
+
+private:
+    enum class JobStage {
+        // read the file, and with an allocate callback only its header
+        Read,
+        // decode the already read file into `dst`
+        Decode,
+        Finished,
+    };
+
+    struct Job {
+        std::string filename;
+        bool flip = false;
+        AllocateCallback allocate;
+        DecodedCallback callback;
+        CancelCallback cancel;
+        DecodedImage image;
+        JobStage stage = JobStage::Read;
+        void* fileData{};
+        size_t fileSize{};
+        void* dst{};
+    };
+
+    static int SDLCALL WorkerMain(void* userdata);
+    void Read(Job& job);
+    void Decode(Job& job);
+    void Push(Job&& job);
+
+    SDL_Mutex* mutex{};
+    SDL_Condition* jobAvailable{};
+    std::vector<SDL_Thread*> threads;
+    std::deque<Job> jobs;
+    // jobs the workers are done with, either finished or waiting for `dst`
+    std::vector<Job> finished;
+    bool quit = false;
+    int outstanding = 0;
+};
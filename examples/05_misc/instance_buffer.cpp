@@ -0,0 +1,86 @@
+#include "instance_buffer.hpp"
+
+// frames of instance data the staging ring holds before it cycles
+constexpr Uint32 StagingFrames = 3;
+constexpr Uint32 StagingAlignment = 16;
+
+bool InstanceBuffer::Init(SDL_GPUDevice* device, Uint32 capacity) {
+    this->device = device;
+    return Resize(capacity);
+}
+
+void InstanceBuffer::Destroy() {
+    SDL_ReleaseGPUBuffer(device, buffer);
+    staging.Destroy();
+    buffer = nullptr;
+    capacity = 0;
+}
+
+bool InstanceBuffer::Upload(SDL_GPUCommandBuffer* cmd, const void* data,
+                            Uint32 size) {
+    if (size == 0) {
+        return true;
+    }
+    if (size > capacity) {
+        // the old buffers are only released after the GPU used them
+        Uint32 new_capacity = SDL_max(capacity, 1024u);
+        while (new_capacity < size) {
+            new_capacity *= 2;
+        }
+        if (!Resize(new_capacity)) {
+            return false;
+        }
+    }
+
+    SDL_GPUTransferBufferLocation src;
+    Uint8* ptr = staging.Allocate(size, StagingAlignment, &src.transfer_buffer,
+                                  &src.offset);
+    if (!ptr) {
+        // the ring wrapped around, older frames may still read it, so
+        // continue in fresh backing memory instead of waiting for them
+        staging.Cycle();
+        ptr = staging.Allocate(size, StagingAlignment, &src.transfer_buffer,
+                               &src.offset);
+    }
+    if (!ptr) {
+        return false;
+    }
+    memcpy(ptr, data, size);
+    staging.Unmap();
+    // batches are never released one by one, the next cycle drops them all
+    staging.Commit();
+
+    SDL_GPUBufferRegion dst;
+    dst.buffer = buffer;
+    dst.offset = 0;
+    dst.size = size;
+
+    SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass(cmd);
+    SDL_UploadToGPUBuffer(copy_pass, &src, &dst, true);
+    SDL_EndGPUCopyPass(copy_pass);
+    return true;
+}
+
+bool InstanceBuffer::Resize(Uint32 capacity) {
+    SDL_GPUBufferCreateInfo buffer_ci{};
+    buffer_ci.size = capacity;
+    buffer_ci.usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ;
+
+    SDL_GPUBuffer* new_buffer = SDL_CreateGPUBuffer(device, &buffer_ci);
+    if (!new_buffer) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU, "create instance buffer failed: %s",
+                     SDL_GetError());
+        return false;
+    }
+    StagingRing new_staging;
+    if (!new_staging.Init(device, capacity * StagingFrames)) {
+        SDL_ReleaseGPUBuffer(device, new_buffer);
+        return false;
+    }
+
+    Destroy();
+    buffer = new_buffer;
+    staging = std::move(new_staging);
+    this->capacity = capacity;
+    return true;
+}
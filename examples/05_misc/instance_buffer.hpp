@@ -0,0 +1,28 @@
+#pragma once
+#include "SDL3/SDL.h"
+#include "staging_ring.hpp"
+
+// Storage buffer for per-instance data the vertex shader reads, rewritten
+// every frame. Each frame's data is sub-allocated from a staging ring that
+// holds a few frames, so frames in flight keep reading their own data and
+// the ring only cycles its backing memory once it wrapped around. The
+// storage buffer is cycled on each upload, so the previous frame's draws
+// can still read the old contents.
+struct InstanceBuffer {
+    bool Init(SDL_GPUDevice* device, Uint32 capacity);
+    void Destroy();
+
+    // records the copy into `cmd`, so it must happen outside of a render
+    // pass. The buffers grow when `size` doesn't fit.
+    bool Upload(SDL_GPUCommandBuffer* cmd, const void* data, Uint32 size);
+
+    SDL_GPUBuffer* Buffer() const { return buffer; }
+
+private:
+    bool Resize(Uint32 capacity);
+
+    SDL_GPUDevice* device{};
+    SDL_GPUBuffer* buffer{};
+    StagingRing staging;
+    Uint32 capacity{};
+};
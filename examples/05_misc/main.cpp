@@ -1,8 +1,28 @@
 #define SDL_MAIN_USE_CALLBACKS
 #include "SDL3/SDL.h"
 #include "SDL3/SDL_main.h"
+#include "gtex.hpp"
+#include "gtex_bc.hpp"
+#include "asset_reader.hpp"
+#include "draw_list.hpp"
+#include "frag.spv.hpp"
+#include "frame_pacer.hpp"
+#include "frustum_culling.hpp"
+#include "image_decoder.hpp"
+#include "instance_buffer.hpp"
+#include "pipeline_cache.hpp"
+#include "profiler.hpp"
+#include "readback_queue.hpp"
+#include "render_targets.hpp"
+#include "shader_hot_reload.hpp"
+#include "shader_meta.hpp"
+#include "transform_store.hpp"
 #include "stb_image.h"
+#include "upload_queue.hpp"
+#include "vert.spv.hpp"
 #include <iostream>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "glm/glm.hpp"
@@ -12,6 +32,8 @@
 struct GPUShaderBundle {
     SDL_GPUShader* vertex{};
     SDL_GPUShader* fragment{};
+    // the vertex input layout is derived from it
+    ShaderMeta vertexMeta;
 
     operator bool() const { return vertex && fragment; }
 };
@@ -22,62 +44,112 @@ bool gShouldExit = false;
 struct GPUResources {
     SDL_GPUDevice* device = nullptr;
     GPUShaderBundle shaders;
-    SDL_GPUGraphicsPipeline* graphicsPipeline{};
+    // owns every pipeline below
+    PipelineCache pipelineCache;
+    // blend off and depth write on, drawn first
+    SDL_GPUGraphicsPipeline* opaquePipeline{};
+    // blend on and depth write off, drawn back to front after opaque draws
+    SDL_GPUGraphicsPipeline* transparentPipeline{};
 
     SDL_GPUBuffer* planeVertexBuffer{};
 
+    // shown until the real texture finished decoding and uploading
+    SDL_GPUTexture* placeholderTexture{};
     SDL_GPUTexture* transparentTexture{};
     SDL_GPUTexture* floorTexture{};
-    SDL_GPUTexture* depthTexture{};
     SDL_GPUSampler* sampler{};
+    RenderTargets renderTargets;
+
+    UploadQueue uploadQueue;
+    InstanceBuffer instanceBuffer;
+    FramePacer framePacer;
+    ReadbackQueue readbackQueue;
 
     void Destroy() {
+        framePacer.Destroy();
+        readbackQueue.Destroy();
+        uploadQueue.Destroy();
+        instanceBuffer.Destroy();
+        renderTargets.Destroy();
         SDL_ReleaseGPUSampler(device, sampler);
-        SDL_ReleaseGPUTexture(device, transparentTexture);
-        SDL_ReleaseGPUTexture(device, floorTexture);
-        SDL_ReleaseGPUTexture(device, depthTexture);
+        if (transparentTexture != placeholderTexture) {
+            SDL_ReleaseGPUTexture(device, transparentTexture);
+        }
+        if (floorTexture != placeholderTexture) {
+            SDL_ReleaseGPUTexture(device, floorTexture);
+        }
+        SDL_ReleaseGPUTexture(device, placeholderTexture);
         SDL_ReleaseGPUBuffer(device, planeVertexBuffer);
-        SDL_ReleaseGPUGraphicsPipeline(device, graphicsPipeline);
+        pipelineCache.Destroy();
         SDL_ReleaseGPUShader(device, shaders.vertex);
         SDL_ReleaseGPUShader(device, shaders.fragment);
-        SDL_ReleaseWindowFromGPUDevice(device, gWindow);
+        if (gWindow) {
+            SDL_ReleaseWindowFromGPUDevice(device, gWindow);
+        }
         SDL_DestroyGPUDevice(device);
     }
 } gGPUResources;
 
+TransformStore gTransforms;
+
 struct Plane {
-    glm::vec3 position;
-    glm::vec3 rotation;
-    glm::vec3 scale = glm::vec3(1, 1, 1);
+    TransformStore::Handle transform;
     glm::vec4 color;
-    SDL_GPUTexture* texture{};
+    // blended, drawn back to front after all opaque planes
+    bool transparent = false;
+    // points to a texture slot in `gGPUResources`, so the plane picks up the
+    // real texture once it replaced the placeholder
+    SDL_GPUTexture** texture{};
 };
 
 std::vector<Plane> gPlanes;
+// indices into `gPlanes`
+std::vector<Uint32> gVisiblePlanes;
+
+struct CullingStats {
+    Uint32 drawn;
+    Uint32 culled;
+} gCullingStats;
+
+AssetReader gAssetReader;
+ImageDecoder gImageDecoder;
+int gPendingTextureLoads = 0;
+bool gTexturesLoaded = false;
+Uint64 gInitBeginTime = 0;
 
 struct FlyCamera {
     void MoveTo(const glm::vec3& p) {
         position = p;
+        dirty = true;
     }
 
     void Move(const glm::vec3& offset) {
         position += offset;
+        dirty = true;
     }
 
     void RotateX(float angle) {
         rotation.x += angle;
         rotation.x = glm::clamp(rotation.x, -89.0f, 89.0f);
+        dirty = true;
     }
 
     void RotateY(float angle) {
         rotation.y += angle;
+        dirty = true;
     }
     
     const glm::mat4& GetMat() const {
         return mat;
     }
 
-    void Update() {
+    // returns whether the view matrix changed
+    bool Update() {
+        if (!dirty) {
+            return false;
+        }
+        dirty = false;
+
         mat =
             glm::translate(
             glm::rotate(
@@ -86,24 +158,202 @@ struct FlyCamera {
                 -glm::radians(rotation.y), glm::vec3(0, 1, 0)),
                 -glm::radians(rotation.z), glm::vec3(0, 0, 1)),
                 -position);
+        return true;
     }
 
 private:
     glm::mat4 mat = glm::mat4(1.0);
     glm::vec3 position = glm::vec3(0, 0, 0);
     glm::vec3 rotation = glm::vec3(0, 0, 0);
+    bool dirty = true;
 } gCamera;
 
 struct MVP {
     glm::mat4 proj;
     glm::mat4 view;
-    glm::mat4 model;
 } gMVP;
 
+// matches `Instance` in shader.vert (std430)
+struct PlaneInstance {
+    glm::mat4 model;
+    glm::vec4 color;
+};
+
+// matches `View` in shader.vert (std140)
+struct ViewUniform {
+    glm::mat4 viewProj;
+    Uint32 baseInstance;
+    Uint32 padding[3];
+};
+
+// consecutive sorted draws sharing their state, drawn with a single
+// instanced draw call
+struct DrawBatch {
+    SDL_GPUTexture* texture;
+    bool transparent;
+    Uint32 firstInstance;
+    Uint32 instanceCount;
+};
+
+std::vector<PlaneInstance> gInstances;
+std::vector<DrawBatch> gDrawBatches;
+std::vector<DrawItem> gDrawItems;
+std::vector<DrawItem> gDrawItemScratch;
+// textures seen while building the draw list, the sort keys store indices
+std::vector<SDL_GPUTexture*> gDrawTextures;
+
 #define WINDOW_WIDTH 1024
 #define WINDOW_HEIGHT 720
 
+// shared by the pipelines and the depth target, they have to agree
+constexpr SDL_GPUTextureFormat DepthFormat = SDL_GPU_TEXTUREFORMAT_D16_UNORM;
+
+#define TRANSPARENT_IMAGE "examples/05_misc/assets/blending_transparent_window.png"
+#define FLOOR_IMAGE "examples/05_misc/assets/floor.png"
+// cooked at build time from the images above, see cook_texture(). The asset
+// reader's paths are relative to this directory.
+#ifndef COOKED_TEXTURE_DIR
+#define COOKED_TEXTURE_DIR "examples/05_misc/assets/"
+#endif
+#define TRANSPARENT_TEXTURE "blending_transparent_window.gtex"
+#define FLOOR_TEXTURE "floor.gtex"
+// the compiler of the build, hot reloading finds glslc in PATH without it
+#ifndef GLSLC_PATH
+#define GLSLC_PATH "glslc"
+#endif
+
+struct Options {
+    // decode images with and without stb's vertical flip, log the timings
+    // and exit
+    bool benchImageFlip = false;
+    std::vector<const char*> benchImages;
+    // extra planes scattered around the scene, for stress testing
+    int extraPlanes = 0;
+    bool culling = true;
+    // frames the GPU may queue before acquiring a swapchain image fails
+    Uint32 framesInFlight = 2;
+    // sleep in the swapchain acquire instead of simulating on
+    bool blockingAcquire = false;
+    // vsync caps the frame rate, immediate is uncapped and may tear, mailbox
+    // is uncapped without tearing and shows the newest frame
+    SDL_GPUPresentMode presentMode = SDL_GPU_PRESENTMODE_VSYNC;
+    // render `headlessFrames` frames into an offscreen target of this size
+    // without opening a window, log the timing and exit
+    bool headless = false;
+    Uint32 headlessWidth = 0;
+    Uint32 headlessHeight = 0;
+    int headlessFrames = 100;
+    // headless runs save their last frame here, for golden image tests
+    const char* screenshotPath = nullptr;
+    // record every frame and write <prefix>.csv and <prefix>.json (Chrome
+    // trace) on exit
+    const char* profilePrefix = nullptr;
+    // recompile shader.vert and shader.frag when they are saved and swap
+    // the new shaders in
+    bool hotReload = false;
+} gOptions;
+
+Profiler gProfiler;
+
+// set by F12, the next rendered frame is read back and saved there
+std::string gPendingScreenshot;
+int gScreenshotCount = 0;
+
+struct HeadlessRun {
+    int frames = 0;
+    Uint64 beginTime = 0;
+    // set once the --screenshot file was written
+    bool screenshotSaved = false;
+} gHeadlessRun;
+
+// offscreen color target format when there is no swapchain
+constexpr SDL_GPUTextureFormat HeadlessColorFormat =
+    SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+
+const char* presentModeName(SDL_GPUPresentMode mode) {
+    switch (mode) {
+        case SDL_GPU_PRESENTMODE_IMMEDIATE:
+            return "immediate";
+        case SDL_GPU_PRESENTMODE_MAILBOX:
+            return "mailbox";
+        default:
+            return "vsync";
+    }
+}
+
+bool parsePresentMode(const char* name, SDL_GPUPresentMode* out) {
+    const SDL_GPUPresentMode modes[] = {SDL_GPU_PRESENTMODE_VSYNC,
+                                        SDL_GPU_PRESENTMODE_IMMEDIATE,
+                                        SDL_GPU_PRESENTMODE_MAILBOX};
+    for (auto mode : modes) {
+        if (SDL_strcmp(name, presentModeName(mode)) == 0) {
+            *out = mode;
+            return true;
+        }
+    }
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "unknown present mode %s, expected vsync, immediate or "
+                 "mailbox",
+                 name);
+    return false;
+}
+
+bool parseOptions(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (SDL_strcmp(argv[i], "--bench-image-flip") == 0) {
+            gOptions.benchImageFlip = true;
+        } else if (SDL_strcmp(argv[i], "--bench-image") == 0 && i + 1 < argc) {
+            gOptions.benchImageFlip = true;
+            gOptions.benchImages.push_back(argv[++i]);
+        } else if (SDL_strcmp(argv[i], "--planes") == 0 && i + 1 < argc) {
+            gOptions.extraPlanes = SDL_max(SDL_atoi(argv[++i]), 0);
+        } else if (SDL_strcmp(argv[i], "--no-culling") == 0) {
+            gOptions.culling = false;
+        } else if (SDL_strcmp(argv[i], "--frames-in-flight") == 0 &&
+                   i + 1 < argc) {
+            gOptions.framesInFlight = SDL_max(SDL_atoi(argv[++i]), 1);
+        } else if (SDL_strcmp(argv[i], "--blocking-acquire") == 0) {
+            gOptions.blockingAcquire = true;
+        } else if (SDL_strcmp(argv[i], "--headless") == 0 && i + 1 < argc) {
+            int w = 0, h = 0;
+            if (SDL_sscanf(argv[++i], "%dx%d", &w, &h) != 2 || w <= 0 ||
+                h <= 0) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                             "invalid headless size %s, expected WxH",
+                             argv[i]);
+                return false;
+            }
+            gOptions.headless = true;
+            gOptions.headlessWidth = w;
+            gOptions.headlessHeight = h;
+        } else if (SDL_strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            gOptions.headlessFrames = SDL_max(SDL_atoi(argv[++i]), 1);
+        } else if (SDL_strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            gOptions.profilePrefix = argv[++i];
+        } else if (SDL_strcmp(argv[i], "--hot-reload") == 0) {
+            gOptions.hotReload = true;
+        } else if (SDL_strcmp(argv[i], "--screenshot") == 0 && i + 1 < argc) {
+            gOptions.screenshotPath = argv[++i];
+        } else if (SDL_strcmp(argv[i], "--present-mode") == 0 &&
+                   i + 1 < argc) {
+            if (!parsePresentMode(argv[++i], &gOptions.presentMode)) {
+                return false;
+            }
+        } else {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "unknown option %s",
+                         argv[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
 bool initSDL() {
+    if (gOptions.headless) {
+        // the GPU backends still load through the video subsystem, the
+        // offscreen driver needs no display. SDL_VIDEO_DRIVER overrides it.
+        SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+    }
     if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS)) {
         SDL_LogError(SDL_LOG_CATEGORY_SYSTEM, "SDL init failed");
         return false;
@@ -125,7 +375,12 @@ bool initSDL() {
         return false;
     }
 
-    gWindow = SDL_CreateWindow("cube", WINDOW_WIDTH, WINDOW_HEIGHT, 0);
+    if (gOptions.headless) {
+        return true;
+    }
+
+    gWindow = SDL_CreateWindow("cube", WINDOW_WIDTH, WINDOW_HEIGHT,
+                               SDL_WINDOW_RESIZABLE);
     if (!gWindow) {
         SDL_LogError(SDL_LOG_CATEGORY_VIDEO, "SDL create gWindow failed");
         return false;
@@ -139,105 +394,127 @@ bool initSDL() {
     return true;
 }
 
-SDL_GPUShader* loadSDLGPUShader(const char* filename, SDL_Storage* storage,
-                                SDL_GPUShaderStage stage, uint32_t sampler_num,
-                                uint32_t uniform_buffer_num) {
-    Uint64 file_size;
-    if (!SDL_GetStorageFileSize(storage, filename, &file_size)) {
-        SDL_LogError(SDL_LOG_CATEGORY_SYSTEM, "get file %s size failed!: %s",
-                     filename, SDL_GetError());
+// resource counts come from the meta text compile_shader writes next to the
+// shader, so they can't get out of sync with the GLSL
+SDL_GPUShader* loadSDLGPUShader(const char* name, const Uint8* code,
+                                size_t code_size, const char* meta_text,
+                                SDL_GPUShaderStage stage, ShaderMeta* out_meta) {
+    ShaderMeta meta;
+    if (!shaderMetaParse(meta_text, SDL_strlen(meta_text), &meta)) {
+        SDL_LogError(SDL_LOG_CATEGORY_SYSTEM, "parse %s meta failed!", name);
         return {};
     }
-
-    std::vector<Uint8> data(file_size);
-    if (!SDL_ReadStorageFile(storage, filename, data.data(), file_size)) {
-        SDL_LogError(SDL_LOG_CATEGORY_SYSTEM, "read file %s failed!: %s",
-                     filename, SDL_GetError());
+    ShaderMetaStage expected_stage = stage == SDL_GPU_SHADERSTAGE_VERTEX
+                                         ? ShaderMetaStage::Vertex
+                                         : ShaderMetaStage::Fragment;
+    if (meta.stage != expected_stage) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU, "%s is not a %s shader", name,
+                     stage == SDL_GPU_SHADERSTAGE_VERTEX ? "vertex"
+                                                         : "fragment");
         return {};
     }
 
-    SDL_GPUShaderCreateInfo ci;
-    ci.code = data.data();
-    ci.code_size = data.size();
+    SDL_GPUShaderCreateInfo ci{};
+    ci.code = code;
+    ci.code_size = code_size;
     ci.entrypoint = "main";
     ci.format = SDL_GPU_SHADERFORMAT_SPIRV;
-    ci.num_samplers = sampler_num;
-    ci.num_uniform_buffers = uniform_buffer_num;
-    ci.num_storage_buffers = 0;
-    ci.num_storage_textures = 0;
+    ci.num_samplers = meta.numSamplers;
+    ci.num_uniform_buffers = meta.numUniformBuffers;
+    ci.num_storage_buffers = meta.numStorageBuffers;
+    ci.num_storage_textures = meta.numStorageTextures;
     ci.stage = stage;
 
     SDL_GPUShader* shader = SDL_CreateGPUShader(gGPUResources.device, &ci);
     if (!shader) {
         SDL_LogError(SDL_LOG_CATEGORY_GPU,
-                     "create gpu shader from %s failed: %s", filename,
+                     "create gpu shader from %s failed: %s", name,
                      SDL_GetError());
         return {};
     }
+    if (out_meta) {
+        *out_meta = std::move(meta);
+    }
     return shader;
 }
 
+// the SPIR-V is compiled into the executable (compile_shader EMBED), so
+// loading needs no file I/O and works from any working directory
 GPUShaderBundle createSDLGPUShaderBundle() {
-    const char* dir = "examples/05_misc";
-    SDL_Storage* storage = SDL_OpenFileStorage(dir);
-    if (!storage) {
-        SDL_LogError(
-            SDL_LOG_CATEGORY_SYSTEM,
-            "Open storage %s failed! You must run this program at root dir!",
-            dir);
-        return {};
-    }
-
-    while (!SDL_StorageReady(storage)) {
-        SDL_Delay(1);
-    }
-
     GPUShaderBundle bundle;
-    bundle.vertex =
-        loadSDLGPUShader("vert.spv", storage, SDL_GPU_SHADERSTAGE_VERTEX, 0, 1);
-    bundle.fragment = loadSDLGPUShader("frag.spv", storage,
-                                       SDL_GPU_SHADERSTAGE_FRAGMENT, 1, 1);
-
-    SDL_CloseStorage(storage);
+    bundle.vertex = loadSDLGPUShader("vert.spv", vert_spv, sizeof(vert_spv),
+                                     vert_spv_meta, SDL_GPU_SHADERSTAGE_VERTEX,
+                                     &bundle.vertexMeta);
+    bundle.fragment = loadSDLGPUShader("frag.spv", frag_spv, sizeof(frag_spv),
+                                       frag_spv_meta,
+                                       SDL_GPU_SHADERSTAGE_FRAGMENT, nullptr);
     return bundle;
 }
 
-SDL_GPUGraphicsPipeline* createGraphicsPipeline() {
-    SDL_GPUGraphicsPipelineCreateInfo ci{};
-
-    SDL_GPUVertexAttribute attributes[2];
-
-    // position attribute
-    {
-        attributes[0].location = 0;
-        attributes[0].buffer_slot = 0;
-        attributes[0].format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3;
-        attributes[0].offset = 0;
+SDL_GPUVertexElementFormat toVertexElementFormat(const ShaderMetaInput& input) {
+    const SDL_GPUVertexElementFormat float_formats[] = {
+        SDL_GPU_VERTEXELEMENTFORMAT_FLOAT, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2,
+        SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4};
+    const SDL_GPUVertexElementFormat int_formats[] = {
+        SDL_GPU_VERTEXELEMENTFORMAT_INT, SDL_GPU_VERTEXELEMENTFORMAT_INT2,
+        SDL_GPU_VERTEXELEMENTFORMAT_INT3, SDL_GPU_VERTEXELEMENTFORMAT_INT4};
+    const SDL_GPUVertexElementFormat uint_formats[] = {
+        SDL_GPU_VERTEXELEMENTFORMAT_UINT, SDL_GPU_VERTEXELEMENTFORMAT_UINT2,
+        SDL_GPU_VERTEXELEMENTFORMAT_UINT3, SDL_GPU_VERTEXELEMENTFORMAT_UINT4};
+
+    switch (input.type) {
+        case ShaderMetaType::Int:
+            return int_formats[input.components - 1];
+        case ShaderMetaType::Uint:
+            return uint_formats[input.components - 1];
+        default:
+            return float_formats[input.components - 1];
     }
+}
 
-    // uv attribute
-    {
-        attributes[1].location = 1;
-        attributes[1].buffer_slot = 0;
-        attributes[1].format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2;
-        attributes[1].offset = sizeof(float) * 3;
+// create info of a pipeline variant with the arrays it points to, it must
+// not be copied or moved
+struct PipelineDesc {
+    SDL_GPUGraphicsPipelineCreateInfo ci{};
+    std::vector<SDL_GPUVertexAttribute> attributes;
+    SDL_GPUVertexBufferDescription vertexBuffer{};
+    SDL_GPUColorTargetDescription colorTarget{};
+};
+
+void describeGraphicsPipeline(const GPUShaderBundle& shaders, bool transparent,
+                              PipelineDesc* out) {
+    SDL_GPUGraphicsPipelineCreateInfo& ci = out->ci;
+
+    // the shader inputs are interleaved in one buffer, tightly packed in
+    // location order, which is how `Vertex` is laid out
+    std::vector<SDL_GPUVertexAttribute>& attributes = out->attributes;
+    Uint32 offset = 0;
+    for (auto& input : shaders.vertexMeta.inputs) {
+        SDL_GPUVertexAttribute attribute{};
+        attribute.location = input.location;
+        attribute.buffer_slot = 0;
+        attribute.format = toVertexElementFormat(input);
+        attribute.offset = offset;
+        attributes.push_back(attribute);
+        offset += input.components * 4;
     }
 
-    ci.vertex_input_state.vertex_attributes = attributes;
-    ci.vertex_input_state.num_vertex_attributes = std::size(attributes);
+    ci.vertex_input_state.vertex_attributes = attributes.data();
+    ci.vertex_input_state.num_vertex_attributes =
+        static_cast<Uint32>(attributes.size());
 
-    SDL_GPUVertexBufferDescription buffer_desc;
+    SDL_GPUVertexBufferDescription& buffer_desc = out->vertexBuffer;
     buffer_desc.input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX;
     buffer_desc.instance_step_rate = 1;
     buffer_desc.slot = 0;
-    buffer_desc.pitch = sizeof(float) * 5;
+    buffer_desc.pitch = offset;
 
     ci.vertex_input_state.num_vertex_buffers = 1;
     ci.vertex_input_state.vertex_buffer_descriptions = &buffer_desc;
 
     ci.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST;
-    ci.vertex_shader = gGPUResources.shaders.vertex;
-    ci.fragment_shader = gGPUResources.shaders.fragment;
+    ci.vertex_shader = shaders.vertex;
+    ci.fragment_shader = shaders.fragment;
 
     ci.rasterizer_state.cull_mode = SDL_GPU_CULLMODE_BACK;
     ci.rasterizer_state.front_face = SDL_GPU_FRONTFACE_COUNTER_CLOCKWISE;
@@ -248,7 +525,7 @@ SDL_GPUGraphicsPipeline* createGraphicsPipeline() {
 
     ci.target_info.num_color_targets = 1;
     ci.target_info.has_depth_stencil_target = true;
-    ci.target_info.depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D16_UNORM;
+    ci.target_info.depth_stencil_format = DepthFormat;
 
     // depth stencil state
     SDL_GPUDepthStencilState state{};
@@ -258,13 +535,14 @@ SDL_GPUGraphicsPipeline* createGraphicsPipeline() {
     state.back_stencil_state.depth_fail_op = SDL_GPU_STENCILOP_ZERO;
     state.compare_op = SDL_GPU_COMPAREOP_LESS;
     state.enable_depth_test = true;
-    state.enable_depth_write = true;
+    // transparent surfaces must not hide what is behind them
+    state.enable_depth_write = !transparent;
     state.enable_stencil_test = false;
     state.compare_mask = 0xFF;
     state.write_mask = 0xFF;
     ci.depth_stencil_state = state;
 
-    SDL_GPUColorTargetDescription desc;
+    SDL_GPUColorTargetDescription& desc = out->colorTarget;
     desc.blend_state.alpha_blend_op = SDL_GPU_BLENDOP_ADD;
     desc.blend_state.color_blend_op = SDL_GPU_BLENDOP_ADD;
     desc.blend_state.color_write_mask =
@@ -274,14 +552,107 @@ SDL_GPUGraphicsPipeline* createGraphicsPipeline() {
     desc.blend_state.src_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
     desc.blend_state.dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ZERO;
     desc.blend_state.dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
-    desc.blend_state.enable_blend = true;
+    desc.blend_state.enable_blend = transparent;
     desc.blend_state.enable_color_write_mask = false;
-    desc.format =
-        SDL_GetGPUSwapchainTextureFormat(gGPUResources.device, gWindow);
+    desc.format = gWindow ? SDL_GetGPUSwapchainTextureFormat(
+                                gGPUResources.device, gWindow)
+                          : HeadlessColorFormat;
 
     ci.target_info.color_target_descriptions = &desc;
+}
+
+ShaderHotReload gShaderHotReload;
+
+// reloaded shaders and their pipeline variants, swapped in once the cache's
+// worker built every variant
+struct PendingShaders {
+    GPUShaderBundle shaders;
+    PipelineDesc opaque;
+    PipelineDesc transparent;
+};
+std::unique_ptr<PendingShaders> gPendingShaders;
 
-    return SDL_CreateGPUGraphicsPipeline(gGPUResources.device, &ci);
+// releases a hot reloaded shader with its cached pipelines, a later shader
+// can get the same address and must not hit them
+void releaseShader(SDL_GPUShader* shader) {
+    gGPUResources.pipelineCache.ReleaseShader(shader);
+    SDL_ReleaseGPUShader(gGPUResources.device, shader);
+}
+
+// releases the shaders of `shaders` that `in_use` doesn't share
+void releaseUnusedShaders(const GPUShaderBundle& shaders,
+                          const GPUShaderBundle& in_use) {
+    if (shaders.vertex != in_use.vertex) {
+        releaseShader(shaders.vertex);
+    }
+    if (shaders.fragment != in_use.fragment) {
+        releaseShader(shaders.fragment);
+    }
+}
+
+// called at the start of a frame, so every draw of a frame uses the same
+// shaders
+void updateHotReload() {
+    PipelineCache& cache = gGPUResources.pipelineCache;
+
+    // newer reloads wait in gShaderHotReload until the pending ones are in
+    if (!gPendingShaders) {
+        std::vector<ShaderHotReload::Reloaded> reloaded =
+            gShaderHotReload.Poll();
+        if (reloaded.empty()) {
+            return;
+        }
+
+        gPendingShaders = std::make_unique<PendingShaders>();
+        GPUShaderBundle& shaders = gPendingShaders->shaders;
+        shaders = gGPUResources.shaders;
+        // a stage saved twice meanwhile is reloaded twice, the later wins
+        for (auto& shader : reloaded) {
+            bool vertex = shader.stage == SDL_GPU_SHADERSTAGE_VERTEX;
+            SDL_GPUShader*& slot = vertex ? shaders.vertex : shaders.fragment;
+            SDL_GPUShader* in_use = vertex ? gGPUResources.shaders.vertex
+                                           : gGPUResources.shaders.fragment;
+            if (slot != in_use) {
+                releaseShader(slot);
+            }
+            slot = shader.shader;
+            if (vertex) {
+                shaders.vertexMeta = std::move(shader.meta);
+            }
+        }
+
+        describeGraphicsPipeline(shaders, false, &gPendingShaders->opaque);
+        describeGraphicsPipeline(shaders, true, &gPendingShaders->transparent);
+        const SDL_GPUGraphicsPipelineCreateInfo pipeline_infos[] = {
+            gPendingShaders->opaque.ci, gPendingShaders->transparent.ci};
+        cache.Prewarm(pipeline_infos, (int)std::size(pipeline_infos));
+    }
+
+    SDL_GPUGraphicsPipeline* opaque = nullptr;
+    SDL_GPUGraphicsPipeline* transparent = nullptr;
+    if (!cache.TryGet(gPendingShaders->opaque.ci, &opaque) ||
+        !cache.TryGet(gPendingShaders->transparent.ci, &transparent)) {
+        return;
+    }
+
+    if (!opaque || !transparent) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU,
+                     "reloaded shaders don't build a pipeline, keeping the "
+                     "old ones");
+        releaseUnusedShaders(gPendingShaders->shaders, gGPUResources.shaders);
+        gPendingShaders.reset();
+        return;
+    }
+
+    // the old objects may still be used by frames in flight, SDL defers
+    // destroying them until the GPU is done with them
+    releaseUnusedShaders(gGPUResources.shaders, gPendingShaders->shaders);
+
+    gGPUResources.shaders = std::move(gPendingShaders->shaders);
+    gGPUResources.opaquePipeline = opaque;
+    gGPUResources.transparentPipeline = transparent;
+    gPendingShaders.reset();
+    SDL_Log("shaders reloaded");
 }
 
 struct Vertex {
@@ -301,112 +672,324 @@ void createAndUploadVertexData() {
     };
     //clang-format on
 
-    SDL_GPUTransferBufferCreateInfo transfer_buffer_ci;
-    transfer_buffer_ci.size = sizeof(vertices);
-    transfer_buffer_ci.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
-
-    SDL_GPUTransferBuffer* transfer_buffer =
-        SDL_CreateGPUTransferBuffer(gGPUResources.device, &transfer_buffer_ci);
-    void* ptr = SDL_MapGPUTransferBuffer(gGPUResources.device, transfer_buffer, false);
-    memcpy(ptr, &vertices, sizeof(vertices));
-    SDL_UnmapGPUTransferBuffer(gGPUResources.device, transfer_buffer);
-
     SDL_GPUBufferCreateInfo gpu_buffer_ci;
     gpu_buffer_ci.size = sizeof(vertices);
     gpu_buffer_ci.usage = SDL_GPU_BUFFERUSAGE_VERTEX;
 
     gGPUResources.planeVertexBuffer = SDL_CreateGPUBuffer(gGPUResources.device, &gpu_buffer_ci);
 
-    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer(gGPUResources.device);
-    SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass(cmd);
-    SDL_GPUTransferBufferLocation location;
-    location.offset = 0;
-    location.transfer_buffer = transfer_buffer;
     SDL_GPUBufferRegion region;
     region.buffer = gGPUResources.planeVertexBuffer;
     region.offset = 0;
     region.size = sizeof(vertices);
-    SDL_UploadToGPUBuffer(copy_pass, &location, &region, false);
-    SDL_EndGPUCopyPass(copy_pass);
-
-    SDL_SubmitGPUCommandBuffer(cmd);
-
-    SDL_ReleaseGPUTransferBuffer(gGPUResources.device, transfer_buffer);
+    gGPUResources.uploadQueue.UploadToBuffer(region, vertices);
 }
 
-SDL_GPUTexture* createImageTexture(const char* filename) {
-    int w, h;
-    stbi_set_flip_vertically_on_load(true);
-    unsigned char* data =
-        stbi_load(filename, &w, &h, NULL, STBI_rgb_alpha);
-
-    size_t image_size = 4 * w * h;
-    SDL_GPUTransferBufferCreateInfo transfer_buffer_ci;
-    transfer_buffer_ci.size = image_size;
-    transfer_buffer_ci.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
-
-    SDL_GPUTransferBuffer* transfer_buffer =
-        SDL_CreateGPUTransferBuffer(gGPUResources.device, &transfer_buffer_ci);
-    void* ptr = SDL_MapGPUTransferBuffer(gGPUResources.device, transfer_buffer, false);
-    memcpy(ptr, data, image_size);
-    SDL_UnmapGPUTransferBuffer(gGPUResources.device, transfer_buffer);
+// levels of a full mip chain down to 1x1
+Uint32 mipLevelCount(int w, int h) {
+    Uint32 levels = 1;
+    for (int size = SDL_max(w, h); size > 1; size >>= 1) {
+        levels++;
+    }
+    return levels;
+}
 
+SDL_GPUTexture* createTexture2D(SDL_GPUTextureFormat format, int w, int h,
+                                Uint32 num_levels,
+                                SDL_GPUTextureUsageFlags usage) {
     SDL_GPUTextureCreateInfo texture_ci;
-    texture_ci.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+    texture_ci.format = format;
     texture_ci.height = h;
     texture_ci.width = w;
     texture_ci.layer_count_or_depth = 1;
-    texture_ci.num_levels = 1;
+    texture_ci.num_levels = num_levels;
     texture_ci.sample_count = SDL_GPU_SAMPLECOUNT_1;
     texture_ci.type = SDL_GPU_TEXTURETYPE_2D;
-    texture_ci.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
-
-    SDL_GPUTexture* texture = SDL_CreateGPUTexture(gGPUResources.device, &texture_ci);
-
-    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer(gGPUResources.device);
-    SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass(cmd);
+    texture_ci.usage = usage;
 
-    SDL_GPUTextureTransferInfo transfer_info;
-    transfer_info.offset = 0;
-    transfer_info.pixels_per_row = w;
-    transfer_info.rows_per_layer = h;
-    transfer_info.transfer_buffer = transfer_buffer;
+    return SDL_CreateGPUTexture(gGPUResources.device, &texture_ci);
+}
 
+// the whole of mip level `level`
+SDL_GPUTextureRegion textureLevelRegion(SDL_GPUTexture* texture, int w, int h,
+                                        Uint32 level) {
     SDL_GPUTextureRegion region;
     region.w = w;
     region.h = h;
     region.x = 0;
     region.y = 0;
     region.layer = 0;
-    region.mip_level = 0;
+    region.mip_level = level;
     region.z = 0;
     region.d = 1;
     region.texture = texture;
+    return region;
+}
 
-    SDL_UploadToGPUTexture(copy_pass, &transfer_info, &region, false);
-    SDL_EndGPUCopyPass(copy_pass);
+// `region` covers mip level 0 of the whole texture, for uploading its pixels,
+// the other levels are generated by `generateMipmaps()` afterwards
+SDL_GPUTexture* createEmptyImageTexture(int w, int h,
+                                        SDL_GPUTextureRegion* region) {
+    // generating mipmaps renders into the texture
+    SDL_GPUTexture* texture = createTexture2D(
+        SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM, w, h, mipLevelCount(w, h),
+        SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COLOR_TARGET);
 
-    SDL_SubmitGPUCommandBuffer(cmd);
+    *region = textureLevelRegion(texture, w, h, 0);
+    return texture;
+}
 
-    SDL_ReleaseGPUTransferBuffer(gGPUResources.device, transfer_buffer);
+// must be queued after level 0's upload, uploading may flush the queue
+void generateMipmaps(SDL_GPUTexture* texture, int w, int h) {
+    if (texture && mipLevelCount(w, h) > 1) {
+        gGPUResources.uploadQueue.GenerateMipmaps(texture);
+    }
+}
+
+SDL_GPUTexture* createImageTexture(int w, int h, const void* data) {
+    SDL_GPUTextureRegion region;
+    SDL_GPUTexture* texture = createEmptyImageTexture(w, h, &region);
 
-    stbi_image_free(data);
+    // the queue copies the pixels into staging memory, so the caller can
+    // free them right away
+    gGPUResources.uploadQueue.UploadToTexture(region, data, 4 * w * h);
+    generateMipmaps(texture, w, h);
 
     return texture;
 }
 
-void createDepthTexture(int w, int h) {
-    SDL_GPUTextureCreateInfo texture_ci;
-    texture_ci.format = SDL_GPU_TEXTUREFORMAT_D16_UNORM;
-    texture_ci.height = h;
-    texture_ci.width = w;
-    texture_ci.layer_count_or_depth = 1;
-    texture_ci.num_levels = 1;
-    texture_ci.sample_count = SDL_GPU_SAMPLECOUNT_1;
-    texture_ci.type = SDL_GPU_TEXTURETYPE_2D;
-    texture_ci.usage = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET;
+void createPlaceholderTexture() {
+    const Uint8 white[] = {255, 255, 255, 255};
+    gGPUResources.placeholderTexture = createImageTexture(1, 1, white);
+}
+
+void flushTextureLoads() {
+    gGPUResources.uploadQueue.Flush([]() {
+        gTexturesLoaded = true;
+        SDL_Log("all textures loaded in %.2f ms",
+                (SDL_GetTicksNS() - gInitBeginTime) / 1000000.0);
+    });
+}
+
+void finishTextureLoad() {
+    gPendingTextureLoads--;
+    if (gPendingTextureLoads == 0) {
+        flushTextureLoads();
+    }
+}
+
+// `slot` shows the placeholder texture until the image is decoded on a
+// worker thread and uploaded. The worker decodes straight into mapped
+// staging memory, so the pixels are never copied on the CPU.
+void loadImageTextureAsync(const char* filename, SDL_GPUTexture** slot) {
+    *slot = gGPUResources.placeholderTexture;
+    gPendingTextureLoads++;
+
+    auto upload = std::make_shared<UploadQueue::MappedUpload>();
+    auto allocate = [upload](int w, int h) -> void* {
+        if (!gGPUResources.uploadQueue.BeginMappedUpload(4 * w * h,
+                                                         upload.get())) {
+            return nullptr;
+        }
+        return upload->ptr;
+    };
+
+    auto cancel = [upload]() {
+        if (upload->buffer) {
+            gGPUResources.uploadQueue.CancelMappedUpload(*upload);
+        }
+    };
+
+    // the vertex shader flips v, so stb doesn't need to flip the rows
+    gImageDecoder.Request(filename, false, allocate, [slot, upload](DecodedImage& image) {
+        if (image.pixels && upload->buffer) {
+            SDL_GPUTextureRegion region;
+            *slot = createEmptyImageTexture(image.width, image.height, &region);
+            gGPUResources.uploadQueue.SubmitMappedTexture(*upload, region);
+            generateMipmaps(*slot, image.width, image.height);
+        } else if (upload->buffer) {
+            gGPUResources.uploadQueue.CancelMappedUpload(*upload);
+        } else if (image.pixels) {
+            // no staging memory was available, stb decoded to the heap
+            *slot = createImageTexture(image.width, image.height, image.pixels);
+        }
+        finishTextureLoad();
+    }, cancel);
+}
+
+SDL_GPUTextureFormat toGPUTextureFormat(GTexFormat format) {
+    switch (format) {
+        case GTexFormat::RGBA8:
+            return SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+        case GTexFormat::BC1:
+            return SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM;
+        case GTexFormat::BC7:
+            return SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM;
+    }
+    return SDL_GPU_TEXTUREFORMAT_INVALID;
+}
+
+// Cooked textures already contain every mip level in upload layout, so the
+// file is read straight into staging memory and each level is uploaded from
+// where it landed. Block compressed textures the GPU can't sample are decoded
+// to RGBA8 on the CPU instead. `upload` is the staging memory `data` was read
+// into, or empty when it was read into the heap.
+bool createCookedTexture(const char* filename, const Uint8* data, Uint64 size,
+                         const UploadQueue::MappedUpload& upload,
+                         SDL_GPUTexture** slot) {
+    const GTexLevel* levels = gtexValidate(data, size);
+    if (!levels) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "%s is not a valid cooked texture", filename);
+        return false;
+    }
+    auto header = reinterpret_cast<const GTexHeader*>(data);
+
+    SDL_GPUTextureFormat format = toGPUTextureFormat(header->format);
+    bool transcode = header->format != GTexFormat::RGBA8 &&
+                     !SDL_GPUTextureSupportsFormat(
+                         gGPUResources.device, format,
+                         SDL_GPU_TEXTURETYPE_2D, SDL_GPU_TEXTUREUSAGE_SAMPLER);
+    if (transcode) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_GPU,
+                    "%s: block compression unsupported, decoding to RGBA8",
+                    filename);
+        format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+    }
+
+    SDL_GPUTexture* texture = createTexture2D(
+        format, header->width, header->height, header->levelCount,
+        SDL_GPU_TEXTUREUSAGE_SAMPLER);
+    if (!texture) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU, "create texture for %s failed: %s",
+                     filename, SDL_GetError());
+        return false;
+    }
+
+    std::vector<SDL_GPUTextureRegion> regions(header->levelCount);
+    std::vector<Uint32> offsets(header->levelCount);
+    for (Uint32 i = 0; i < header->levelCount; i++) {
+        regions[i] = textureLevelRegion(texture, levels[i].width,
+                                        levels[i].height, i);
+        offsets[i] = static_cast<Uint32>(levels[i].offset);
+    }
 
-    gGPUResources.depthTexture = SDL_CreateGPUTexture(gGPUResources.device, &texture_ci);
+    if (upload.buffer && !transcode) {
+        // GTEX_DATA_ALIGNMENT keeps every level at a valid upload offset
+        gGPUResources.uploadQueue.SubmitMappedTextures(
+            upload, regions.data(), offsets.data(), (int)regions.size());
+    } else {
+        // transcoding reads the mapped memory back, which is slow but rare
+        std::vector<Uint8> pixels;
+        for (Uint32 i = 0; i < header->levelCount; i++) {
+            const GTexLevel& level = levels[i];
+            if (transcode) {
+                pixels.resize(size_t(level.width) * level.height * 4);
+                gtexDecodeLevel(header->format, data + level.offset,
+                                level.width, level.height, pixels.data());
+                gGPUResources.uploadQueue.UploadToTexture(
+                    regions[i], pixels.data(),
+                    static_cast<Uint32>(pixels.size()));
+            } else {
+                gGPUResources.uploadQueue.UploadToTexture(
+                    regions[i], data + level.offset,
+                    static_cast<Uint32>(level.size));
+            }
+        }
+        if (upload.buffer) {
+            gGPUResources.uploadQueue.CancelMappedUpload(upload);
+        }
+    }
+
+    *slot = texture;
+    return true;
+}
+
+// `slot` shows the placeholder texture until the cooked texture is read on
+// the asset reader's worker and uploaded. It falls back to decoding the
+// source image when the cooked one is missing or invalid.
+void loadTexture(const char* cooked_filename, const char* image_filename,
+                 SDL_GPUTexture** slot) {
+    *slot = gGPUResources.placeholderTexture;
+    gPendingTextureLoads++;
+
+    auto upload = std::make_shared<UploadQueue::MappedUpload>();
+    auto allocate = [upload](Uint64 size) -> void* {
+        if (size > SDL_MAX_UINT32 ||
+            !gGPUResources.uploadQueue.BeginMappedUpload(
+                static_cast<Uint32>(size), upload.get())) {
+            return nullptr;
+        }
+        return upload->ptr;
+    };
+
+    auto cancel = [upload]() {
+        if (upload->buffer) {
+            gGPUResources.uploadQueue.CancelMappedUpload(*upload);
+        }
+    };
+
+    std::string image = image_filename;
+    gAssetReader.Read(
+        cooked_filename, allocate,
+        [slot, upload, image](const char* path, void* data, Uint64 size) {
+            // no staging memory was available when it was read to the heap
+            if (data != upload->ptr && upload->buffer) {
+                gGPUResources.uploadQueue.CancelMappedUpload(*upload);
+                *upload = {};
+            }
+
+            bool created =
+                data && createCookedTexture(path, static_cast<Uint8*>(data),
+                                            size, *upload, slot);
+            if (!created) {
+                if (upload->buffer) {
+                    gGPUResources.uploadQueue.CancelMappedUpload(*upload);
+                }
+                SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                            "load cooked texture %s failed, decoding %s",
+                            path, image.c_str());
+                loadImageTextureAsync(image.c_str(), slot);
+            }
+            finishTextureLoad();
+        },
+        cancel);
+}
+
+// Flipping on load is one more pass over all pixels after decoding, this
+// measures what flipping v in the vertex shader saves us.
+void benchmarkImageFlip(const char* filename) {
+    size_t file_size;
+    void* file_data = SDL_LoadFile(filename, &file_size);
+    if (!file_data) {
+        SDL_LogError(SDL_LOG_CATEGORY_SYSTEM, "read image %s failed: %s",
+                     filename, SDL_GetError());
+        return;
+    }
+
+    const int iterations = 10;
+    int w = 0, h = 0;
+    double decode_ms[2];
+    for (int flip = 0; flip < 2; flip++) {
+        stbi_set_flip_vertically_on_load_thread(flip);
+
+        Uint64 begin = SDL_GetPerformanceCounter();
+        for (int i = 0; i < iterations; i++) {
+            unsigned char* pixels = stbi_load_from_memory(
+                static_cast<stbi_uc*>(file_data), file_size, &w, &h, nullptr,
+                STBI_rgb_alpha);
+            stbi_image_free(pixels);
+        }
+        decode_ms[flip] = (SDL_GetPerformanceCounter() - begin) * 1000.0 /
+                          SDL_GetPerformanceFrequency() / iterations;
+    }
+    stbi_set_flip_vertically_on_load_thread(false);
+    SDL_free(file_data);
+
+    SDL_Log("%s (%dx%d): decode %.3f ms, decode + flip %.3f ms, flip "
+            "costs %.3f ms",
+            filename, w, h, decode_ms[0], decode_ms[1],
+            decode_ms[1] - decode_ms[0]);
 }
 
 void createSampler() {
@@ -419,111 +1002,252 @@ void createSampler() {
     ci.enable_compare = false;
     ci.mag_filter = SDL_GPU_FILTER_LINEAR;
     ci.min_filter = SDL_GPU_FILTER_LINEAR;
-    ci.max_lod = 1.0;
-    ci.min_lod = 1.0;
+    // use the whole mip chain
+    ci.max_lod = 1000.0;
+    ci.min_lod = 0.0;
     ci.mip_lod_bias = 0.0;
     ci.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR;
 
     gGPUResources.sampler = SDL_CreateGPUSampler(gGPUResources.device, &ci);
 }
 
+void updateProjection(Uint32 width, Uint32 height) {
+    gMVP.proj = glm::perspective(glm::radians(45.0f), (float)width / (float)height, 0.01f, 1000.0f);
+}
+
 void initMVPData() {
-    gMVP.proj = glm::perspective(glm::radians(45.0f), (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT, 0.01f, 1000.0f);
-    gMVP.model = glm::mat4(1.0);
+    updateProjection(WINDOW_WIDTH, WINDOW_HEIGHT);
     gMVP.view = glm::mat4(1.0);
 }
 
+// plane `i` owns transform `i`, so culling results index `gPlanes` directly
+void addPlane(const glm::vec3& position, const glm::quat& rotation,
+              const glm::vec3& scale, const glm::vec4& color,
+              SDL_GPUTexture** texture, bool transparent) {
+    Plane plane;
+    plane.color = color;
+    plane.transparent = transparent;
+    plane.transform = gTransforms.Add(position, rotation, scale);
+    plane.texture = texture;
+    SDL_assert(plane.transform == gPlanes.size());
+
+    // the plane mesh is a unit quad in the xy plane
+    gTransforms.SetLocalBounds(plane.transform, glm::vec3(0, 0, 0),
+                               glm::vec3(0.5, 0.5, 0));
+    gPlanes.push_back(plane);
+}
+
 void initPlanes() {
     // floor
-    {
-        Plane plane;
-        plane.color = glm::vec4(1, 1, 1, 1);
-        plane.position = glm::vec3(0, 0, -0.5);
-        plane.rotation = glm::vec3(-90, 0, 0);
-        plane.scale = glm::vec3(10, 10, 10);
-        plane.texture = gGPUResources.floorTexture;
-
-        gPlanes.push_back(plane);
+    addPlane(glm::vec3(0, -0.5, 0), glm::quat(glm::radians(glm::vec3(-90, 0, 0))),
+             glm::vec3(10, 10, 10), glm::vec4(1, 1, 1, 1),
+             &gGPUResources.floorTexture, false);
+
+    addPlane(glm::vec3(0.2, 0, -4), glm::quat(1, 0, 0, 0), glm::vec3(1, 1, 1),
+             glm::vec4(0.5, 0, 0, 1), &gGPUResources.transparentTexture, true);
+    addPlane(glm::vec3(-0.2, 0, -3), glm::quat(1, 0, 0, 0), glm::vec3(1, 1, 1),
+             glm::vec4(0.5, 0, 0, 1), &gGPUResources.transparentTexture, true);
+
+    for (int i = 0; i < gOptions.extraPlanes; i++) {
+        addPlane(glm::vec3(SDL_randf() * 100 - 50, SDL_randf() * 10,
+                           SDL_randf() * 100 - 50),
+                 glm::angleAxis(SDL_randf() * 2 * SDL_PI_F, glm::vec3(0, 1, 0)),
+                 glm::vec3(1, 1, 1),
+                 glm::vec4(SDL_randf(), SDL_randf(), SDL_randf(), 1),
+                 &gGPUResources.transparentTexture, true);
     }
-    
-    {
-        Plane plane;
-        plane.color = glm::vec4(0.5, 0, 0, 1);
-        plane.position = glm::vec3(0.2, 0, -4);
-        plane.rotation = glm::vec3(0, 0, 0);
-        plane.texture = gGPUResources.transparentTexture;
+}
 
-        gPlanes.push_back(plane);
+// Fills `gVisiblePlanes` with the planes inside the camera frustum.
+void cullPlanes(const glm::mat4& view_proj) {
+    gVisiblePlanes.clear();
+    if (gOptions.culling) {
+        cullBounds(extractFrustum(view_proj), gTransforms.GetWorldBounds(),
+                   gPlanes.size(), gVisiblePlanes);
+    } else {
+        for (size_t i = 0; i < gPlanes.size(); i++) {
+            gVisiblePlanes.push_back(static_cast<Uint32>(i));
+        }
     }
 
-    {
-        Plane plane;
-        plane.color = glm::vec4(0.5, 0, 0, 1);
-        plane.position = glm::vec3(-0.2, 0, -3);
-        plane.rotation = glm::vec3(0, 0, 0);
-        plane.texture = gGPUResources.transparentTexture;
-
-        gPlanes.push_back(plane);
-    }
+    gCullingStats.drawn = static_cast<Uint32>(gVisiblePlanes.size());
+    gCullingStats.culled =
+        static_cast<Uint32>(gPlanes.size() - gVisiblePlanes.size());
 }
 
-// SDL main loop
+// pipeline ids in the draw keys
+constexpr Uint32 OpaquePipelineId = 0;
+constexpr Uint32 TransparentPipelineId = 1;
 
-SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv) {
-    if (!initSDL()) {
-        return SDL_APP_FAILURE;
+Uint32 drawTextureIndex(SDL_GPUTexture* texture) {
+    // only a handful of textures, a linear search is fine
+    for (size_t i = 0; i < gDrawTextures.size(); i++) {
+        if (gDrawTextures[i] == texture) {
+            return static_cast<Uint32>(i);
+        }
     }
+    gDrawTextures.push_back(texture);
+    return static_cast<Uint32>(gDrawTextures.size() - 1);
+}
 
-    gGPUResources.shaders = createSDLGPUShaderBundle();
-    if (!gGPUResources.shaders) {
-        SDL_LogError(SDL_LOG_CATEGORY_GPU, "Shader load failed! Program exit!");
-        return SDL_APP_FAILURE;
+// Sorts the visible planes by their draw keys (see draw_list.hpp) and
+// writes their instances in that order. Runs of planes with the same state
+// become one draw batch.
+void buildDrawBatches(const glm::mat4& view) {
+    const TransformStore::WorldBounds& bounds = gTransforms.GetWorldBounds();
+
+    gDrawTextures.clear();
+    gDrawItems.clear();
+    for (Uint32 index : gVisiblePlanes) {
+        const Plane& plane = gPlanes[index];
+        Uint32 texture = drawTextureIndex(*plane.texture);
+        // distance along the view direction, the camera looks down -z
+        float depth = -(view[0][2] * bounds.centerX[index] +
+                        view[1][2] * bounds.centerY[index] +
+                        view[2][2] * bounds.centerZ[index] + view[3][2]);
+
+        DrawItem item;
+        item.index = index;
+        item.key = plane.transparent
+                       ? makeTransparentDrawKey(TransparentPipelineId, texture,
+                                                depth)
+                       : makeOpaqueDrawKey(OpaquePipelineId, texture, depth);
+        gDrawItems.push_back(item);
     }
+    radixSortDrawItems(gDrawItems, gDrawItemScratch);
+
+    gDrawBatches.clear();
+    gInstances.resize(gDrawItems.size());
+    for (size_t i = 0; i < gDrawItems.size(); i++) {
+        const Plane& plane = gPlanes[gDrawItems[i].index];
+        SDL_GPUTexture* texture = *plane.texture;
+        if (gDrawBatches.empty() || gDrawBatches.back().texture != texture ||
+            gDrawBatches.back().transparent != plane.transparent) {
+            gDrawBatches.push_back(DrawBatch{texture, plane.transparent,
+                                             static_cast<Uint32>(i), 0});
+        }
+        gDrawBatches.back().instanceCount++;
 
-    gGPUResources.graphicsPipeline = createGraphicsPipeline();
-    if (!gGPUResources.graphicsPipeline) {
-        SDL_LogError(SDL_LOG_CATEGORY_GPU, "Graphics pipeline load failed! %s",
-                     SDL_GetError());
-        return SDL_APP_FAILURE;
+        PlaneInstance& instance = gInstances[i];
+        instance.model = gTransforms.GetMat(plane.transform);
+        instance.color = plane.color;
     }
+}
 
-    SDL_SetWindowRelativeMouseMode(gWindow, true);
-
-    createAndUploadVertexData();
-    gGPUResources.transparentTexture = createImageTexture("examples/05_misc/assets/blending_transparent_window.png");
-    gGPUResources.floorTexture = createImageTexture("examples/05_misc/assets/floor.png");
-    createDepthTexture(WINDOW_WIDTH, WINDOW_HEIGHT);
-    createSampler();
-    initMVPData();
-
-    initPlanes();
-
-    return SDL_APP_CONTINUE;
+// the counters are shown in the window title, refreshed once per second
+void updateWindowTitle() {
+    static Uint64 last_update = 0;
+    Uint64 now = SDL_GetTicks();
+    if (now - last_update < 1000) {
+        return;
+    }
+    last_update = now;
+
+    // pacer times are averaged over the frames of the last second
+    FramePacer& pacer = gGPUResources.framePacer;
+    const FramePacer::Stats& stats = pacer.GetStats();
+    double frames = (double)SDL_max(stats.frames, (Uint64)1);
+    char title[256];
+    SDL_snprintf(title, sizeof(title),
+                 "05_misc - drawn %u, culled %u, %llu fps (%s), frame p50 "
+                 "%.2f ms p99 %.2f ms, cpu wait %.2f ms, gpu idle %.2f ms",
+                 gCullingStats.drawn, gCullingStats.culled,
+                 (unsigned long long)stats.frames,
+                 presentModeName(pacer.GetPresentMode()),
+                 gProfiler.FrameTimePercentile(50),
+                 gProfiler.FrameTimePercentile(99),
+                 stats.cpuWaitNS / frames / 1e6, stats.gpuIdleNS / frames / 1e6);
+    if (gWindow) {
+        SDL_SetWindowTitle(gWindow, title);
+    }
+    pacer.ResetStats();
 }
 
-SDL_AppResult SDL_AppIterate(void* appstate) {
-    gCamera.Update();
-    gMVP.view = gCamera.GetMat();
-    
-    bool is_minimized = SDL_GetWindowFlags(gWindow) & SDL_WINDOW_MINIMIZED;
-    if (is_minimized) {
-        return SDL_APP_CONTINUE;
+SDL_PixelFormat toPixelFormat(SDL_GPUTextureFormat format) {
+    // SDL names packed formats from the most significant bit, so the byte
+    // order is reversed on little endian machines
+    switch (format) {
+        case SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM:
+            return SDL_PIXELFORMAT_ABGR8888;
+        case SDL_GPU_TEXTUREFORMAT_B8G8R8A8_UNORM:
+            return SDL_PIXELFORMAT_ARGB8888;
+        default:
+            return SDL_PIXELFORMAT_UNKNOWN;
     }
+}
 
-    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer(gGPUResources.device);
-    SDL_GPUTexture* swapchain_texture = nullptr;
-    Uint32 width, height;
+// reads the color target back once the GPU finished the frame and writes it
+// to `filename`, called after the frame was recorded
+bool queueScreenshot(const std::string& filename) {
+    RenderTargets& render_targets = gGPUResources.renderTargets;
+    SDL_PixelFormat pixel_format = toPixelFormat(render_targets.ColorFormat());
+    if (pixel_format == SDL_PIXELFORMAT_UNKNOWN) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "can't save color target format %d",
+                     render_targets.ColorFormat());
+        return false;
+    }
 
-    if (!SDL_WaitAndAcquireGPUSwapchainTexture(cmd, gWindow, &swapchain_texture,
-                                               &width, &height)) {
-        SDL_LogError(SDL_LOG_CATEGORY_GPU,
-                     "SDL swapchain texture acquire failed! %s",
-                     SDL_GetError());
+    SDL_GPUTextureRegion region{};
+    region.texture = render_targets.Color();
+    region.w = render_targets.Width();
+    region.h = render_targets.Height();
+    region.d = 1;
+    Uint32 w = region.w;
+    Uint32 h = region.h;
+    bool queued = gGPUResources.readbackQueue.ReadTexture(
+        region, w * h * 4,
+        [filename, pixel_format, w, h](const Uint8* data, Uint32 size) {
+            SDL_Surface* surface = SDL_CreateSurfaceFrom(
+                w, h, pixel_format, const_cast<Uint8*>(data), w * 4);
+            if (!surface || !SDL_SaveBMP(surface, filename.c_str())) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                             "save screenshot %s failed: %s",
+                             filename.c_str(), SDL_GetError());
+            } else {
+                SDL_Log("saved screenshot %s", filename.c_str());
+                gHeadlessRun.screenshotSaved = true;
+            }
+            SDL_DestroySurface(surface);
+        });
+    if (!queued) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "read back screenshot %s failed", filename.c_str());
+        return false;
     }
+    return gGPUResources.readbackQueue.Flush();
+}
 
-    if (!swapchain_texture) {
-        return SDL_APP_CONTINUE;
+SDL_AppResult finishHeadlessRun() {
+    // the last frames may still be queued on the GPU
+    SDL_WaitForGPUIdle(gGPUResources.device);
+    gGPUResources.readbackQueue.WaitIdle();
+    double total_ms = (SDL_GetTicksNS() - gHeadlessRun.beginTime) / 1e6;
+    SDL_Log("headless: %d frames at %ux%u in %.2f ms, %.3f ms per frame, "
+            "p50 %.3f ms, p99 %.3f ms",
+            gHeadlessRun.frames, gOptions.headlessWidth,
+            gOptions.headlessHeight, total_ms, total_ms / gHeadlessRun.frames,
+            gProfiler.FrameTimePercentile(50),
+            gProfiler.FrameTimePercentile(99));
+    if (gOptions.screenshotPath && !gHeadlessRun.screenshotSaved) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "no screenshot saved to %s",
+                     gOptions.screenshotPath);
+        return SDL_APP_FAILURE;
     }
+    return SDL_APP_SUCCESS;
+}
+
+// records the frame into `cmd`, rendering to `swapchain_texture` or, when
+// there is none or the frame is captured, to the offscreen color target
+void recordFrame(SDL_GPUCommandBuffer* cmd, SDL_GPUTexture* swapchain_texture,
+                 Uint32 width, Uint32 height, const glm::mat4& view_proj,
+                 bool capture) {
+    RenderTargets& render_targets = gGPUResources.renderTargets;
+
+    Uint32 instance_bytes =
+        static_cast<Uint32>(gInstances.size() * sizeof(PlaneInstance));
+    gGPUResources.instanceBuffer.Upload(cmd, gInstances.data(), instance_bytes);
+    gProfiler.AddCounter(ProfileCounter::UploadBytes, instance_bytes);
 
     SDL_GPUColorTargetInfo color_target_info{};
     color_target_info.clear_color.r = 0.1;
@@ -533,7 +1257,11 @@ SDL_AppResult SDL_AppIterate(void* appstate) {
     color_target_info.load_op = SDL_GPU_LOADOP_CLEAR;
     color_target_info.mip_level = 0;
     color_target_info.store_op = SDL_GPU_STOREOP_STORE;
-    color_target_info.texture = swapchain_texture;
+    // frames that are read back go through the color target, swapchain
+    // textures can't be downloaded
+    color_target_info.texture = swapchain_texture && !capture
+                                    ? swapchain_texture
+                                    : render_targets.Color();
     color_target_info.cycle = true;
     color_target_info.layer_or_depth_plane = 0;
     color_target_info.cycle_resolve_texture = false;
@@ -543,57 +1271,306 @@ SDL_AppResult SDL_AppIterate(void* appstate) {
     depth_target_info.cycle = false;
     depth_target_info.load_op = SDL_GPU_LOADOP_CLEAR;
     depth_target_info.store_op = SDL_GPU_STOREOP_DONT_CARE;
-    depth_target_info.texture = gGPUResources.depthTexture;
+    depth_target_info.texture = render_targets.Depth();
     
     SDL_GPURenderPass* render_pass =
         SDL_BeginGPURenderPass(cmd, &color_target_info, 1, &depth_target_info);
-    SDL_BindGPUGraphicsPipeline(render_pass, gGPUResources.graphicsPipeline);
-
-    SDL_GPUBufferBinding binding;
-    binding.buffer = gGPUResources.planeVertexBuffer;
-    binding.offset = 0;
-    SDL_BindGPUVertexBuffers(render_pass, 0, &binding, 1);
-
-    int window_width, window_height;
-    SDL_GetWindowSize(gWindow, &window_width, &window_height);
 
     SDL_GPUViewport viewport;
     viewport.x = 0;
     viewport.y = 0;
-    viewport.w = window_width;
-    viewport.h = window_height;
+    viewport.w = width;
+    viewport.h = height;
     viewport.min_depth = 0;
     viewport.max_depth = 1;
     SDL_SetGPUViewport(render_pass, &viewport);
 
-    for (auto& plane : gPlanes) {
-        MVP mvp = gMVP;
-        
-        mvp.model =
-            glm::scale(
-            glm::translate(
-                        glm::rotate(
-                            glm::rotate(
-                                glm::rotate(glm::mat4(1.0),
-                                    glm::radians(plane.rotation.x), glm::vec3(1, 0, 0)),
-                                glm::radians(plane.rotation.y), glm::vec3(0, 1, 0)),
-                            glm::radians(plane.rotation.z), glm::vec3(0, 0, 1)),
-                        plane.position), plane.scale);
+    SDL_GPUBufferBinding binding;
+    binding.buffer = gGPUResources.planeVertexBuffer;
+    binding.offset = 0;
+    SDL_GPUBuffer* instance_buffer = gGPUResources.instanceBuffer.Buffer();
+
+    ViewUniform view_uniform{};
+    view_uniform.viewProj = view_proj;
+    SDL_GPUGraphicsPipeline* bound_pipeline = nullptr;
+    for (auto& batch : gDrawBatches) {
+        // batches are sorted, so every pipeline is bound once
+        SDL_GPUGraphicsPipeline* pipeline =
+            batch.transparent ? gGPUResources.transparentPipeline
+                              : gGPUResources.opaquePipeline;
+        if (pipeline != bound_pipeline) {
+            SDL_BindGPUGraphicsPipeline(render_pass, pipeline);
+            SDL_BindGPUVertexBuffers(render_pass, 0, &binding, 1);
+            SDL_BindGPUVertexStorageBuffers(render_pass, 0, &instance_buffer, 1);
+            bound_pipeline = pipeline;
+        }
 
         SDL_GPUTextureSamplerBinding sampler_binding;
-        sampler_binding.texture = plane.texture;
+        sampler_binding.texture = batch.texture;
         sampler_binding.sampler = gGPUResources.sampler;
         SDL_BindGPUFragmentSamplers(render_pass, 0, &sampler_binding, 1);
-        SDL_PushGPUVertexUniformData(cmd, 0, &mvp, sizeof(mvp));
-        SDL_PushGPUFragmentUniformData(cmd, 0, &plane.color, sizeof(plane.color));
-        SDL_DrawGPUPrimitives(render_pass, 6, 1, 0, 0);
+
+        // the shader offsets gl_InstanceIndex itself, so first_instance
+        // stays 0
+        view_uniform.baseInstance = batch.firstInstance;
+        SDL_PushGPUVertexUniformData(cmd, 0, &view_uniform,
+                                     sizeof(view_uniform));
+        SDL_DrawGPUPrimitives(render_pass, 6, batch.instanceCount, 0, 0);
+        gProfiler.AddCounter(ProfileCounter::DrawCalls, 1);
+        gProfiler.AddCounter(ProfileCounter::UniformBytes,
+                             sizeof(view_uniform));
     }
 
     SDL_EndGPURenderPass(render_pass);
 
-    if (!SDL_SubmitGPUCommandBuffer(cmd)) {
-        SDL_LogError(SDL_LOG_CATEGORY_GPU,
-                     "SDL submit command buffer failed! %s", SDL_GetError());
+    if (capture && swapchain_texture) {
+        SDL_GPUBlitInfo blit_info{};
+        blit_info.source.texture = render_targets.Color();
+        blit_info.source.w = width;
+        blit_info.source.h = height;
+        blit_info.destination.texture = swapchain_texture;
+        blit_info.destination.w = width;
+        blit_info.destination.h = height;
+        blit_info.load_op = SDL_GPU_LOADOP_DONT_CARE;
+        blit_info.filter = SDL_GPU_FILTER_NEAREST;
+        SDL_BlitGPUTexture(cmd, &blit_info);
+    }
+}
+
+// SDL main loop
+
+SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv) {
+    gInitBeginTime = SDL_GetTicksNS();
+
+    if (!parseOptions(argc, argv)) {
+        return SDL_APP_FAILURE;
+    }
+
+    gProfiler.Init(gOptions.profilePrefix != nullptr);
+
+    if (gOptions.benchImageFlip) {
+        if (gOptions.benchImages.empty()) {
+            gOptions.benchImages = {TRANSPARENT_IMAGE, FLOOR_IMAGE};
+        }
+        for (auto filename : gOptions.benchImages) {
+            benchmarkImageFlip(filename);
+        }
+        return SDL_APP_SUCCESS;
+    }
+
+    if (!initSDL()) {
+        return SDL_APP_FAILURE;
+    }
+
+    if (!gGPUResources.uploadQueue.Init(gGPUResources.device,
+                                        32 * 1024 * 1024)) {
+        return SDL_APP_FAILURE;
+    }
+
+    // the texture reads go out first, so the disk is busy while the shaders,
+    // pipelines and buffers below are created. Paths are relative to
+    // COOKED_TEXTURE_DIR.
+    if (!gAssetReader.Init(COOKED_TEXTURE_DIR)) {
+        return SDL_APP_FAILURE;
+    }
+    createPlaceholderTexture();
+    loadTexture(TRANSPARENT_TEXTURE, TRANSPARENT_IMAGE,
+                &gGPUResources.transparentTexture);
+    loadTexture(FLOOR_TEXTURE, FLOOR_IMAGE, &gGPUResources.floorTexture);
+
+    gGPUResources.shaders = createSDLGPUShaderBundle();
+    if (!gGPUResources.shaders) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU, "Shader load failed! Program exit!");
+        return SDL_APP_FAILURE;
+    }
+
+    // every variant is built on the cache's worker while the textures load
+    // below, the render thread never creates a pipeline
+    if (!gGPUResources.pipelineCache.Init(gGPUResources.device)) {
+        return SDL_APP_FAILURE;
+    }
+    PipelineDesc opaque_desc, transparent_desc;
+    describeGraphicsPipeline(gGPUResources.shaders, false, &opaque_desc);
+    describeGraphicsPipeline(gGPUResources.shaders, true, &transparent_desc);
+    const SDL_GPUGraphicsPipelineCreateInfo pipeline_infos[] = {
+        opaque_desc.ci, transparent_desc.ci};
+    gGPUResources.pipelineCache.Prewarm(pipeline_infos,
+                                        (int)std::size(pipeline_infos));
+
+    if (gWindow) {
+        SDL_SetWindowRelativeMouseMode(gWindow, true);
+    }
+
+    if (!gGPUResources.framePacer.Init(gGPUResources.device, gWindow,
+                                       gOptions.framesInFlight,
+                                       gOptions.blockingAcquire) ||
+        !gGPUResources.framePacer.SetPresentMode(gOptions.presentMode)) {
+        return SDL_APP_FAILURE;
+    }
+
+    if (!gGPUResources.instanceBuffer.Init(gGPUResources.device,
+                                           64 * sizeof(PlaneInstance))) {
+        return SDL_APP_FAILURE;
+    }
+
+    if (!gGPUResources.readbackQueue.Init(gGPUResources.device)) {
+        return SDL_APP_FAILURE;
+    }
+
+    // keep one core for the main thread
+    int decoder_thread_num = SDL_max(SDL_GetNumLogicalCPUCores() - 1, 1);
+    if (!gImageDecoder.Init(decoder_thread_num)) {
+        return SDL_APP_FAILURE;
+    }
+
+    createAndUploadVertexData();
+    // the placeholder and the vertex data share one submission, textures are
+    // uploaded from SDL_AppIterate as their reads finish
+    gGPUResources.uploadQueue.Flush();
+    if (!gGPUResources.renderTargets.Init(
+            gGPUResources.device, DepthFormat,
+            gWindow ? SDL_GetGPUSwapchainTextureFormat(gGPUResources.device,
+                                                       gWindow)
+                    : HeadlessColorFormat)) {
+        return SDL_APP_FAILURE;
+    }
+    createSampler();
+    initMVPData();
+
+    initPlanes();
+
+    gGPUResources.opaquePipeline =
+        gGPUResources.pipelineCache.Get(opaque_desc.ci);
+    gGPUResources.transparentPipeline =
+        gGPUResources.pipelineCache.Get(transparent_desc.ci);
+    if (!gGPUResources.opaquePipeline || !gGPUResources.transparentPipeline) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU, "Graphics pipeline load failed!");
+        return SDL_APP_FAILURE;
+    }
+
+    if (gOptions.hotReload) {
+        if (!gShaderHotReload.Init(gGPUResources.device, GLSLC_PATH)) {
+            return SDL_APP_FAILURE;
+        }
+        gShaderHotReload.Watch("examples/05_misc/shader.vert",
+                               SDL_GPU_SHADERSTAGE_VERTEX);
+        gShaderHotReload.Watch("examples/05_misc/shader.frag",
+                               SDL_GPU_SHADERSTAGE_FRAGMENT);
+    }
+
+    return SDL_APP_CONTINUE;
+}
+
+SDL_AppResult SDL_AppIterate(void* appstate) {
+    {
+        ProfileScope scope(gProfiler, ProfileZone::Update);
+        if (gOptions.hotReload) {
+            updateHotReload();
+        }
+        int loaded = gAssetReader.Poll() + gImageDecoder.Poll();
+        if (loaded > 0) {
+            gGPUResources.uploadQueue.Flush();
+        }
+        gGPUResources.uploadQueue.Update();
+        gGPUResources.readbackQueue.Update();
+
+        if (gCamera.Update()) {
+            gMVP.view = gCamera.GetMat();
+        }
+    }
+    
+    bool is_minimized =
+        gWindow && (SDL_GetWindowFlags(gWindow) & SDL_WINDOW_MINIMIZED);
+    if (is_minimized) {
+        return SDL_APP_CONTINUE;
+    }
+
+    if (gOptions.headless) {
+        // only frames with the real textures count, so runs are comparable
+        if (!gTexturesLoaded) {
+            return SDL_APP_CONTINUE;
+        }
+        if (gHeadlessRun.beginTime == 0) {
+            gHeadlessRun.beginTime = SDL_GetTicksNS();
+        }
+        if (gOptions.screenshotPath &&
+            gHeadlessRun.frames == gOptions.headlessFrames - 1) {
+            gPendingScreenshot = gOptions.screenshotPath;
+        }
+    }
+
+    SDL_GPUCommandBuffer* cmd;
+    SDL_GPUTexture* swapchain_texture;
+    Uint32 width, height;
+    // without a free swapchain image the input and uploads above were still
+    // handled, the frame is rendered on a later iteration
+    bool acquired;
+    {
+        ProfileScope scope(gProfiler, ProfileZone::Acquire);
+        acquired = gGPUResources.framePacer.BeginFrame(
+            &cmd, &swapchain_texture, &width, &height);
+    }
+    if (!acquired) {
+        updateWindowTitle();
+        return SDL_APP_CONTINUE;
+    }
+    if (!swapchain_texture) {
+        width = gOptions.headlessWidth;
+        height = gOptions.headlessHeight;
+    }
+
+    // the swapchain follows the window, so the depth buffer and the aspect
+    // ratio are only touched when its size actually changed
+    RenderTargets& render_targets = gGPUResources.renderTargets;
+    if (!render_targets.Matches(width, height)) {
+        if (!render_targets.Resize(width, height)) {
+            gGPUResources.framePacer.EndFrame(cmd);
+            return SDL_APP_CONTINUE;
+        }
+        updateProjection(width, height);
+    }
+
+    // frames that are read back go through the offscreen color target
+    bool capture = !gPendingScreenshot.empty();
+    if ((capture || !swapchain_texture) && !render_targets.EnsureColor()) {
+        gGPUResources.framePacer.EndFrame(cmd);
+        return SDL_APP_CONTINUE;
+    }
+
+    glm::mat4 view_proj = gMVP.proj * gMVP.view;
+    {
+        ProfileScope scope(gProfiler, ProfileZone::Update);
+        gTransforms.Update();
+        cullPlanes(view_proj);
+        buildDrawBatches(gMVP.view);
+        updateWindowTitle();
+    }
+
+    {
+        ProfileScope scope(gProfiler, ProfileZone::Record);
+        recordFrame(cmd, swapchain_texture, width, height, view_proj, capture);
+    }
+
+    {
+        ProfileScope scope(gProfiler, ProfileZone::Submit);
+        gGPUResources.framePacer.EndFrame(cmd);
+    }
+    gProfiler.AddCounter(ProfileCounter::UploadBytes,
+                         gGPUResources.uploadQueue.TakeSubmittedBytes());
+    gProfiler.EndFrame();
+
+    // the read is submitted after the frame, so it sees the finished image
+    if (capture) {
+        bool queued = queueScreenshot(gPendingScreenshot);
+        gPendingScreenshot.clear();
+        if (!queued && gOptions.headless && gOptions.screenshotPath) {
+            return SDL_APP_FAILURE;
+        }
+    }
+
+    if (gOptions.headless &&
+        ++gHeadlessRun.frames == gOptions.headlessFrames) {
+        return finishHeadlessRun();
     }
 
     return SDL_APP_CONTINUE;
@@ -618,6 +1595,12 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event) {
         if (event->key.key == SDLK_S) {
             gCamera.Move(glm::vec3(0, 0, speed));
         }
+        if (event->key.key == SDLK_F12) {
+            char filename[64];
+            SDL_snprintf(filename, sizeof(filename), "screenshot_%d.bmp",
+                         gScreenshotCount++);
+            gPendingScreenshot = filename;
+        }
         if (event->key.key == SDLK_ESCAPE) {
             return SDL_APP_SUCCESS;
         }
@@ -633,8 +1616,23 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event) {
 }
 
 void SDL_AppQuit(void* appstate, SDL_AppResult result) {
+    if (gOptions.profilePrefix) {
+        std::string prefix = gOptions.profilePrefix;
+        gProfiler.WriteCSV((prefix + ".csv").c_str());
+        gProfiler.WriteChromeTrace((prefix + ".json").c_str());
+    }
+
+    // unfinished loads give their staging memory back to the upload queue
+    gAssetReader.Destroy();
+    gImageDecoder.Destroy();
+    gShaderHotReload.Destroy();
     SDL_WaitForGPUIdle(gGPUResources.device);
 
+    if (gPendingShaders) {
+        releaseUnusedShaders(gPendingShaders->shaders, gGPUResources.shaders);
+        gPendingShaders.reset();
+    }
+
     gGPUResources.Destroy();
     SDL_DestroyWindow(gWindow);
     SDL_Quit();
@@ -0,0 +1,336 @@
+#include "pipeline_cache.hpp"
+
+namespace {
+
+// FNV-1a over the individual fields, hashing whole structs would include
+// their padding
+struct Hasher {
+    Uint64 value = 14695981039346656037ull;
+
+    template <typename T>
+    void Add(const T& field) {
+        const Uint8* bytes = reinterpret_cast<const Uint8*>(&field);
+        for (size_t i = 0; i < sizeof(T); i++) {
+            value = (value ^ bytes[i]) * 1099511628211ull;
+        }
+    }
+
+    void Add(const SDL_GPUStencilOpState& state) {
+        Add(state.fail_op);
+        Add(state.pass_op);
+        Add(state.depth_fail_op);
+        Add(state.compare_op);
+    }
+};
+
+}  // namespace
+
+bool PipelineCache::Init(SDL_GPUDevice* device) {
+    this->device = device;
+    mutex = SDL_CreateMutex();
+    jobAvailable = SDL_CreateCondition();
+    pipelineReady = SDL_CreateCondition();
+    if (!mutex || !jobAvailable || !pipelineReady) {
+        SDL_LogError(SDL_LOG_CATEGORY_SYSTEM,
+                     "create pipeline cache sync objects failed: %s",
+                     SDL_GetError());
+        return false;
+    }
+
+    thread = SDL_CreateThread(WorkerMain, "pipeline cache", this);
+    if (!thread) {
+        SDL_LogError(SDL_LOG_CATEGORY_SYSTEM,
+                     "create pipeline cache thread failed: %s",
+                     SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+void PipelineCache::Destroy() {
+    if (mutex) {
+        SDL_LockMutex(mutex);
+        quit = true;
+        SDL_BroadcastCondition(jobAvailable);
+        SDL_UnlockMutex(mutex);
+    }
+    if (thread) {
+        SDL_WaitThread(thread, nullptr);
+        thread = nullptr;
+    }
+
+    for (auto& [hash, bucket] : pipelines) {
+        for (auto& entry : bucket) {
+            if (entry.pipeline) {
+                SDL_ReleaseGPUGraphicsPipeline(device, entry.pipeline);
+            }
+        }
+    }
+    pipelines.clear();
+    jobs.clear();
+    building.clear();
+
+    SDL_DestroyCondition(pipelineReady);
+    SDL_DestroyCondition(jobAvailable);
+    SDL_DestroyMutex(mutex);
+    pipelineReady = nullptr;
+    jobAvailable = nullptr;
+    mutex = nullptr;
+}
+
+SDL_GPUGraphicsPipeline* PipelineCache::Get(
+    const SDL_GPUGraphicsPipelineCreateInfo& ci) {
+    Uint64 hash = Hash(ci);
+
+    SDL_LockMutex(mutex);
+    while (building.count(hash)) {
+        SDL_WaitCondition(pipelineReady, mutex);
+    }
+    if (Entry* entry = Find(hash, ci)) {
+        SDL_GPUGraphicsPipeline* pipeline = entry->pipeline;
+        SDL_UnlockMutex(mutex);
+        return pipeline;
+    }
+    SDL_UnlockMutex(mutex);
+
+    // only one thread creates pipelines outside of the worker, so nobody
+    // else can insert this entry meanwhile
+    SDL_GPUGraphicsPipeline* pipeline = Create(ci);
+    SDL_LockMutex(mutex);
+    Insert(hash, ci, pipeline);
+    SDL_UnlockMutex(mutex);
+    return pipeline;
+}
+
+bool PipelineCache::TryGet(const SDL_GPUGraphicsPipelineCreateInfo& ci,
+                           SDL_GPUGraphicsPipeline** out) {
+    Uint64 hash = Hash(ci);
+
+    SDL_LockMutex(mutex);
+    Entry* entry = Find(hash, ci);
+    if (entry) {
+        *out = entry->pipeline;
+    }
+    SDL_UnlockMutex(mutex);
+    return entry != nullptr;
+}
+
+void PipelineCache::Prewarm(const SDL_GPUGraphicsPipelineCreateInfo* infos,
+                            int count) {
+    SDL_LockMutex(mutex);
+    for (int i = 0; i < count; i++) {
+        Uint64 hash = Hash(infos[i]);
+        if (building.count(hash) || Find(hash, infos[i])) {
+            continue;
+        }
+
+        OwnedCreateInfo job;
+        job.ci = infos[i];
+        job.hash = hash;
+        const SDL_GPUVertexInputState& input = infos[i].vertex_input_state;
+        job.vertexBuffers.assign(
+            input.vertex_buffer_descriptions,
+            input.vertex_buffer_descriptions + input.num_vertex_buffers);
+        job.vertexAttributes.assign(
+            input.vertex_attributes,
+            input.vertex_attributes + input.num_vertex_attributes);
+        const SDL_GPUGraphicsPipelineTargetInfo& target = infos[i].target_info;
+        job.colorTargets.assign(
+            target.color_target_descriptions,
+            target.color_target_descriptions + target.num_color_targets);
+
+        building.insert(hash);
+        jobs.push_back(std::move(job));
+    }
+    SDL_SignalCondition(jobAvailable);
+    SDL_UnlockMutex(mutex);
+}
+
+void PipelineCache::ReleaseShader(SDL_GPUShader* shader) {
+    std::vector<SDL_GPUGraphicsPipeline*> released;
+    SDL_LockMutex(mutex);
+    // queued jobs would be published under an address a new shader can get
+    for (auto it = jobs.begin(); it != jobs.end();) {
+        if (it->ci.vertex_shader == shader ||
+            it->ci.fragment_shader == shader) {
+            building.erase(it->hash);
+            it = jobs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    // the worker reads the shader until the pipeline is created, then it is
+    // published and evicted below like the others
+    while (currentVertexShader == shader || currentFragmentShader == shader) {
+        SDL_WaitCondition(pipelineReady, mutex);
+    }
+
+    for (auto it = pipelines.begin(); it != pipelines.end();) {
+        std::vector<Entry>& bucket = it->second;
+        for (size_t i = 0; i < bucket.size();) {
+            if (bucket[i].vertexShader == shader ||
+                bucket[i].fragmentShader == shader) {
+                if (bucket[i].pipeline) {
+                    released.push_back(bucket[i].pipeline);
+                }
+                bucket.erase(bucket.begin() + i);
+            } else {
+                i++;
+            }
+        }
+        it = bucket.empty() ? pipelines.erase(it) : std::next(it);
+    }
+    SDL_UnlockMutex(mutex);
+
+    for (auto pipeline : released) {
+        SDL_ReleaseGPUGraphicsPipeline(device, pipeline);
+    }
+}
+
+Uint64 PipelineCache::Hash(const SDL_GPUGraphicsPipelineCreateInfo& ci) {
+    Hasher h;
+    h.Add(ci.vertex_shader);
+    h.Add(ci.fragment_shader);
+
+    const SDL_GPUVertexInputState& input = ci.vertex_input_state;
+    h.Add(input.num_vertex_buffers);
+    for (Uint32 i = 0; i < input.num_vertex_buffers; i++) {
+        const SDL_GPUVertexBufferDescription& desc =
+            input.vertex_buffer_descriptions[i];
+        h.Add(desc.slot);
+        h.Add(desc.pitch);
+        h.Add(desc.input_rate);
+        h.Add(desc.instance_step_rate);
+    }
+    h.Add(input.num_vertex_attributes);
+    for (Uint32 i = 0; i < input.num_vertex_attributes; i++) {
+        const SDL_GPUVertexAttribute& attribute = input.vertex_attributes[i];
+        h.Add(attribute.location);
+        h.Add(attribute.buffer_slot);
+        h.Add(attribute.format);
+        h.Add(attribute.offset);
+    }
+
+    h.Add(ci.primitive_type);
+
+    const SDL_GPURasterizerState& raster = ci.rasterizer_state;
+    h.Add(raster.fill_mode);
+    h.Add(raster.cull_mode);
+    h.Add(raster.front_face);
+    h.Add(raster.depth_bias_constant_factor);
+    h.Add(raster.depth_bias_clamp);
+    h.Add(raster.depth_bias_slope_factor);
+    h.Add(raster.enable_depth_bias);
+    h.Add(raster.enable_depth_clip);
+
+    const SDL_GPUMultisampleState& multisample = ci.multisample_state;
+    h.Add(multisample.sample_count);
+    h.Add(multisample.sample_mask);
+    h.Add(multisample.enable_mask);
+
+    const SDL_GPUDepthStencilState& depth = ci.depth_stencil_state;
+    h.Add(depth.compare_op);
+    h.Add(depth.back_stencil_state);
+    h.Add(depth.front_stencil_state);
+    h.Add(depth.compare_mask);
+    h.Add(depth.write_mask);
+    h.Add(depth.enable_depth_test);
+    h.Add(depth.enable_depth_write);
+    h.Add(depth.enable_stencil_test);
+
+    const SDL_GPUGraphicsPipelineTargetInfo& target = ci.target_info;
+    h.Add(target.num_color_targets);
+    for (Uint32 i = 0; i < target.num_color_targets; i++) {
+        const SDL_GPUColorTargetDescription& desc =
+            target.color_target_descriptions[i];
+        const SDL_GPUColorTargetBlendState& blend = desc.blend_state;
+        h.Add(desc.format);
+        h.Add(blend.src_color_blendfactor);
+        h.Add(blend.dst_color_blendfactor);
+        h.Add(blend.color_blend_op);
+        h.Add(blend.src_alpha_blendfactor);
+        h.Add(blend.dst_alpha_blendfactor);
+        h.Add(blend.alpha_blend_op);
+        h.Add(blend.color_write_mask);
+        h.Add(blend.enable_blend);
+        h.Add(blend.enable_color_write_mask);
+    }
+    h.Add(target.depth_stencil_format);
+    h.Add(target.has_depth_stencil_target);
+
+    h.Add(ci.props);
+    return h.value;
+}
+
+int PipelineCache::WorkerMain(void* userdata) {
+    auto cache = static_cast<PipelineCache*>(userdata);
+
+    SDL_LockMutex(cache->mutex);
+    while (true) {
+        while (cache->jobs.empty() && !cache->quit) {
+            SDL_WaitCondition(cache->jobAvailable, cache->mutex);
+        }
+        if (cache->quit) {
+            break;
+        }
+
+        OwnedCreateInfo job = std::move(cache->jobs.front());
+        cache->jobs.pop_front();
+        cache->currentVertexShader = job.ci.vertex_shader;
+        cache->currentFragmentShader = job.ci.fragment_shader;
+        SDL_UnlockMutex(cache->mutex);
+
+        // point the copied create info at the copied arrays
+        SDL_GPUGraphicsPipelineCreateInfo& ci = job.ci;
+        ci.vertex_input_state.vertex_buffer_descriptions =
+            job.vertexBuffers.data();
+        ci.vertex_input_state.vertex_attributes = job.vertexAttributes.data();
+        ci.target_info.color_target_descriptions = job.colorTargets.data();
+        SDL_GPUGraphicsPipeline* pipeline = cache->Create(ci);
+
+        SDL_LockMutex(cache->mutex);
+        cache->Insert(job.hash, ci, pipeline);
+        cache->building.erase(job.hash);
+        cache->currentVertexShader = nullptr;
+        cache->currentFragmentShader = nullptr;
+        SDL_BroadcastCondition(cache->pipelineReady);
+    }
+    SDL_UnlockMutex(cache->mutex);
+    return 0;
+}
+
+PipelineCache::Entry* PipelineCache::Find(
+    Uint64 hash, const SDL_GPUGraphicsPipelineCreateInfo& ci) {
+    auto it = pipelines.find(hash);
+    if (it == pipelines.end()) {
+        return nullptr;
+    }
+    for (auto& entry : it->second) {
+        if (entry.vertexShader == ci.vertex_shader &&
+            entry.fragmentShader == ci.fragment_shader) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+void PipelineCache::Insert(Uint64 hash,
+                           const SDL_GPUGraphicsPipelineCreateInfo& ci,
+                           SDL_GPUGraphicsPipeline* pipeline) {
+    Entry entry;
+    entry.pipeline = pipeline;
+    entry.vertexShader = ci.vertex_shader;
+    entry.fragmentShader = ci.fragment_shader;
+    pipelines[hash].push_back(entry);
+}
+
+SDL_GPUGraphicsPipeline* PipelineCache::Create(
+    const SDL_GPUGraphicsPipelineCreateInfo& ci) {
+    SDL_GPUGraphicsPipeline* pipeline =
+        SDL_CreateGPUGraphicsPipeline(device, &ci);
+    if (!pipeline) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU, "create pipeline failed: %s",
+                     SDL_GetError());
+    }
+    return pipeline;
+}
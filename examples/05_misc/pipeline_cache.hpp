@@ -0,0 +1,88 @@
+#pragma once
+#include "SDL3/SDL.h"
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Graphics pipelines keyed by a hash of their whole create info (shaders,
+// vertex layout, rasterizer, multisample, depth/stencil, blend and target
+// formats), so every state combination is created once. Known permutations
+// can be handed to `Prewarm()` at startup, they are created on a worker
+// thread while the main thread keeps loading, and the render thread only
+// looks them up.
+//
+// The 64 bit hash is the key. Entries also remember their shaders and a
+// lookup only hits an entry with the same ones, because the hash covers the
+// shader addresses and a released shader's address can come back for a new
+// shader. Collisions of the remaining state are too unlikely to be worth
+// storing and comparing whole create infos.
+struct PipelineCache {
+    bool Init(SDL_GPUDevice* device);
+    // waits for the worker, then releases every pipeline
+    void Destroy();
+
+    // `Get()`, `TryGet()`, `Prewarm()` and `ReleaseShader()` are called from
+    // the main thread only.
+    //
+    // returns the pipeline for `ci`. It is created on the calling thread if
+    // nobody asked for it before, a pipeline the worker still builds is
+    // waited for instead of being created twice.
+    SDL_GPUGraphicsPipeline* Get(const SDL_GPUGraphicsPipelineCreateInfo& ci);
+
+    // like `Get()` but never waits or creates, returns false while `ci` is
+    // still queued or being built and if nobody asked for it. `*out` is null
+    // if creating it failed.
+    bool TryGet(const SDL_GPUGraphicsPipelineCreateInfo& ci,
+                SDL_GPUGraphicsPipeline** out);
+
+    // queues the pipelines for creation on the worker. The create infos are
+    // copied, they don't have to outlive the call.
+    void Prewarm(const SDL_GPUGraphicsPipelineCreateInfo* infos, int count);
+
+    // releases every pipeline built from `shader` and forgets failed
+    // creations with it, call it before releasing the shader. Queued
+    // pipelines with it are dropped and one the worker is creating from it
+    // is waited for.
+    void ReleaseShader(SDL_GPUShader* shader);
+
+    static Uint64 Hash(const SDL_GPUGraphicsPipelineCreateInfo& ci);
+
+private:
+    // a create info with copies of the arrays it points to
+    struct OwnedCreateInfo {
+        SDL_GPUGraphicsPipelineCreateInfo ci{};
+        std::vector<SDL_GPUVertexBufferDescription> vertexBuffers;
+        std::vector<SDL_GPUVertexAttribute> vertexAttributes;
+        std::vector<SDL_GPUColorTargetDescription> colorTargets;
+        Uint64 hash{};
+    };
+
+    struct Entry {
+        SDL_GPUGraphicsPipeline* pipeline{};
+        SDL_GPUShader* vertexShader{};
+        SDL_GPUShader* fragmentShader{};
+    };
+
+    static int SDLCALL WorkerMain(void* userdata);
+    // the entry built from `ci`'s shaders, call with the mutex locked
+    Entry* Find(Uint64 hash, const SDL_GPUGraphicsPipelineCreateInfo& ci);
+    void Insert(Uint64 hash, const SDL_GPUGraphicsPipelineCreateInfo& ci,
+                SDL_GPUGraphicsPipeline* pipeline);
+    SDL_GPUGraphicsPipeline* Create(const SDL_GPUGraphicsPipelineCreateInfo& ci);
+
+    SDL_GPUDevice* device{};
+    SDL_Mutex* mutex{};
+    SDL_Condition* jobAvailable{};
+    SDL_Condition* pipelineReady{};
+    SDL_Thread* thread{};
+    bool quit = false;
+    std::deque<OwnedCreateInfo> jobs;
+    // hashes that are queued or being created on the worker
+    std::unordered_set<Uint64> building;
+    // shaders of the pipeline the worker is creating right now
+    SDL_GPUShader* currentVertexShader{};
+    SDL_GPUShader* currentFragmentShader{};
+    // hashes with entries of different shaders share a bucket
+    std::unordered_map<Uint64, std::vector<Entry>> pipelines;
+};
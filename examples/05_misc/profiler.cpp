@@ -0,0 +1,129 @@
+#include "profiler.hpp"
+#include <algorithm>
+
+// recording stops beyond this, about an hour at 60 fps
+constexpr size_t MaxRecordedFrames = 256 * 1024;
+
+const char* const ZoneNames[] = {"acquire", "update", "record", "submit"};
+const char* const CounterNames[] = {"draw_calls", "uniform_bytes",
+                                    "upload_bytes"};
+
+void Profiler::Init(bool record) {
+    this->record = record;
+    frequency = SDL_GetPerformanceFrequency();
+    startTime = Now();
+    current = {};
+    current.begin = startTime;
+}
+
+void Profiler::AddZone(ProfileZone zone, Uint64 begin, Uint64 end) {
+    current.zoneTicks[(int)zone] += end - begin;
+    if (record && frames.size() < MaxRecordedFrames) {
+        events.push_back({zone, begin, end});
+    }
+}
+
+void Profiler::EndFrame() {
+    current.end = Now();
+    frameTimes[frameCount % FrameWindow] = ToMS(current.end - current.begin);
+    frameCount++;
+
+    if (record && frames.size() < MaxRecordedFrames) {
+        frames.push_back(current);
+    }
+
+    Uint64 end = current.end;
+    current = {};
+    current.begin = end;
+}
+
+double Profiler::FrameTimePercentile(double percentile) const {
+    int count = std::min(frameCount, FrameWindow);
+    if (count == 0) {
+        return 0;
+    }
+
+    // nearest rank
+    double sorted[FrameWindow];
+    std::copy(frameTimes, frameTimes + count, sorted);
+    int rank = (int)SDL_ceil(percentile / 100.0 * count) - 1;
+    rank = SDL_clamp(rank, 0, count - 1);
+    std::nth_element(sorted, sorted + rank, sorted + count);
+    return sorted[rank];
+}
+
+bool Profiler::WriteCSV(const char* filename) const {
+    SDL_IOStream* io = SDL_IOFromFile(filename, "w");
+    if (!io) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "open %s failed: %s",
+                     filename, SDL_GetError());
+        return false;
+    }
+
+    SDL_IOprintf(io, "frame,frame_ms");
+    for (auto name : ZoneNames) {
+        SDL_IOprintf(io, ",%s_ms", name);
+    }
+    for (auto name : CounterNames) {
+        SDL_IOprintf(io, ",%s", name);
+    }
+    SDL_IOprintf(io, "\n");
+
+    for (size_t i = 0; i < frames.size(); i++) {
+        const Frame& frame = frames[i];
+        SDL_IOprintf(io, "%zu,%.4f", i, ToMS(frame.end - frame.begin));
+        for (auto ticks : frame.zoneTicks) {
+            SDL_IOprintf(io, ",%.4f", ToMS(ticks));
+        }
+        for (auto value : frame.counters) {
+            SDL_IOprintf(io, ",%llu", (unsigned long long)value);
+        }
+        SDL_IOprintf(io, "\n");
+    }
+
+    return SDL_CloseIO(io);
+}
+
+bool Profiler::WriteChromeTrace(const char* filename) const {
+    SDL_IOStream* io = SDL_IOFromFile(filename, "w");
+    if (!io) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "open %s failed: %s",
+                     filename, SDL_GetError());
+        return false;
+    }
+
+    // complete events for frames and zones, a counter event per frame
+    SDL_IOprintf(io, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    const char* separator = "";
+    for (size_t i = 0; i < frames.size(); i++) {
+        const Frame& frame = frames[i];
+        SDL_IOprintf(io,
+                     "%s{\"name\":\"frame %zu\",\"ph\":\"X\",\"pid\":0,"
+                     "\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}",
+                     separator, i, ToUS(frame.begin - startTime),
+                     ToUS(frame.end - frame.begin));
+        separator = ",\n";
+
+        SDL_IOprintf(io,
+                     ",\n{\"name\":\"counters\",\"ph\":\"C\",\"pid\":0,"
+                     "\"ts\":%.3f,\"args\":{",
+                     ToUS(frame.end - startTime));
+        for (int c = 0; c < (int)ProfileCounter::Count; c++) {
+            SDL_IOprintf(io, "%s\"%s\":%llu", c ? "," : "", CounterNames[c],
+                         (unsigned long long)frame.counters[c]);
+        }
+        SDL_IOprintf(io, "}}");
+    }
+    for (auto& event : events) {
+        SDL_IOprintf(io,
+                     "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":0,"
+                     "\"ts\":%.3f,\"dur\":%.3f}",
+                     separator, ZoneNames[(int)event.zone],
+                     ToUS(event.begin - startTime),
+                     ToUS(event.end - event.begin));
+        separator = ",\n";
+    }
+    SDL_IOprintf(io, "\n]}\n");
+
+    return SDL_CloseIO(io);
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "SDL3/SDL.h"
+#include <vector>
+
+// CPU side instrumentation of the main loop. Zones are timed with
+// SDL_GetPerformanceCounter and summed per rendered frame, counters are
+// summed the same way. Frame times of the last `FrameWindow` frames are
+// kept for percentiles, and with recording enabled every frame and zone is
+// stored so it can be dumped as CSV or as a Chrome trace (chrome://tracing,
+// ui.perfetto.dev) on exit.
+enum class ProfileZone {
+    // SDL_AcquireGPUSwapchainTexture, including failed attempts
+    Acquire,
+    // polling, transforms, culling and draw list building
+    Update,
+    // command buffer recording
+    Record,
+    // submission, SDL queues the present there too
+    Submit,
+    Count
+};
+
+enum class ProfileCounter {
+    DrawCalls,
+    UniformBytes,
+    UploadBytes,
+    Count
+};
+
+struct Profiler {
+    static constexpr int FrameWindow = 256;
+
+    void Init(bool record);
+
+    Uint64 Now() const { return SDL_GetPerformanceCounter(); }
+    void AddZone(ProfileZone zone, Uint64 begin, Uint64 end);
+    void AddCounter(ProfileCounter counter, Uint64 value) {
+        current.counters[(int)counter] += value;
+    }
+
+    // closes the frame, everything added since the last call belongs to it
+    void EndFrame();
+
+    // frame time in ms below which `percentile` (0..100) of the frames in
+    // the window are
+    double FrameTimePercentile(double percentile) const;
+
+    bool WriteCSV(const char* filename) const;
+    bool WriteChromeTrace(const char* filename) const;
+
+private:
+    struct Frame {
+        Uint64 begin{};
+        Uint64 end{};
+        Uint64 zoneTicks[(int)ProfileZone::Count]{};
+        Uint64 counters[(int)ProfileCounter::Count]{};
+    };
+
+    struct ZoneEvent {
+        ProfileZone zone;
+        Uint64 begin;
+        Uint64 end;
+    };
+
+    double ToMS(Uint64 ticks) const { return ticks * 1000.0 / frequency; }
+    double ToUS(Uint64 ticks) const { return ticks * 1000000.0 / frequency; }
+
+    Uint64 frequency = 1;
+    Uint64 startTime{};
+    bool record = false;
+    Frame current;
+    double frameTimes[FrameWindow]{};
+    int frameCount{};
+    std::vector<Frame> frames;
+    std::vector<ZoneEvent> events;
+};
+
+// times the enclosing block
+struct ProfileScope {
+    ProfileScope(Profiler& profiler, ProfileZone zone)
+        : profiler(profiler), zone(zone), begin(profiler.Now()) {}
+    ~ProfileScope() { profiler.AddZone(zone, begin, profiler.Now()); }
+
+    Profiler& profiler;
+    ProfileZone zone;
+    Uint64 begin;
+};
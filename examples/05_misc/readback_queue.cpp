@@ -0,0 +1,181 @@
+#include "readback_queue.hpp"
+
+// idle download buffers beyond this are released
+constexpr Uint64 MaxIdleBufferBytes = 64 * 1024 * 1024;
+
+bool ReadbackQueue::Init(SDL_GPUDevice* device) {
+    this->device = device;
+    return true;
+}
+
+void ReadbackQueue::Destroy() {
+    WaitIdle();
+
+    for (auto& read : pending) {
+        SDL_ReleaseGPUTransferBuffer(device, read.dst.buffer);
+    }
+    pending.clear();
+    for (auto& buffer : idleBuffers) {
+        SDL_ReleaseGPUTransferBuffer(device, buffer.buffer);
+    }
+    idleBuffers.clear();
+    idleBufferBytes = 0;
+}
+
+bool ReadbackQueue::ReadTexture(const SDL_GPUTextureRegion& region,
+                                Uint32 size, CompleteCallback callback) {
+    PendingRead read;
+    read.size = size;
+    read.texture = region;
+    return QueueRead(read, std::move(callback));
+}
+
+bool ReadbackQueue::ReadBuffer(const SDL_GPUBufferRegion& region,
+                               CompleteCallback callback) {
+    PendingRead read;
+    read.size = region.size;
+    read.buffer = region;
+    return QueueRead(read, std::move(callback));
+}
+
+bool ReadbackQueue::Flush() {
+    if (pending.empty()) {
+        return true;
+    }
+
+    InFlightBatch batch;
+    batch.reads = std::move(pending);
+    pending.clear();
+
+    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer(device);
+    if (!cmd) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU,
+                     "acquire readback command buffer failed: %s",
+                     SDL_GetError());
+        for (auto& read : batch.reads) {
+            ReturnBuffer(read.dst);
+        }
+        return false;
+    }
+
+    SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass(cmd);
+    for (auto& read : batch.reads) {
+        if (read.texture.texture) {
+            // tightly packed
+            SDL_GPUTextureTransferInfo dst{};
+            dst.transfer_buffer = read.dst.buffer;
+            SDL_DownloadFromGPUTexture(copy_pass, &read.texture, &dst);
+        } else {
+            SDL_GPUTransferBufferLocation dst{};
+            dst.transfer_buffer = read.dst.buffer;
+            SDL_DownloadFromGPUBuffer(copy_pass, &read.buffer, &dst);
+        }
+    }
+    SDL_EndGPUCopyPass(copy_pass);
+
+    batch.fence = SDL_SubmitGPUCommandBufferAndAcquireFence(cmd);
+    if (!batch.fence) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU,
+                     "submit readback command buffer failed: %s",
+                     SDL_GetError());
+        for (auto& read : batch.reads) {
+            ReturnBuffer(read.dst);
+        }
+        return false;
+    }
+
+    inFlight.push_back(std::move(batch));
+    return true;
+}
+
+void ReadbackQueue::Update() {
+    size_t i = 0;
+    while (i < inFlight.size()) {
+        if (SDL_QueryGPUFence(device, inFlight[i].fence)) {
+            // callbacks may queue new reads, so take the batch out first
+            InFlightBatch batch = std::move(inFlight[i]);
+            inFlight.erase(inFlight.begin() + i);
+            FinishBatch(batch);
+        } else {
+            i++;
+        }
+    }
+}
+
+void ReadbackQueue::WaitIdle() {
+    while (!inFlight.empty()) {
+        InFlightBatch batch = std::move(inFlight.front());
+        inFlight.erase(inFlight.begin());
+        SDL_WaitForGPUFences(device, true, &batch.fence, 1);
+        FinishBatch(batch);
+    }
+}
+
+bool ReadbackQueue::QueueRead(PendingRead& read, CompleteCallback callback) {
+    if (!AcquireBuffer(read.size, &read.dst)) {
+        return false;
+    }
+    read.callback = std::move(callback);
+    pending.push_back(std::move(read));
+    return true;
+}
+
+bool ReadbackQueue::AcquireBuffer(Uint32 size, DownloadBuffer* out) {
+    // smallest idle buffer that fits, but don't waste more than half of it
+    int best = -1;
+    for (int i = 0; i < (int)idleBuffers.size(); i++) {
+        Uint32 idle_size = idleBuffers[i].size;
+        if (idle_size >= size && idle_size / 2 <= size &&
+            (best < 0 || idle_size < idleBuffers[best].size)) {
+            best = i;
+        }
+    }
+
+    if (best >= 0) {
+        *out = idleBuffers[best];
+        idleBuffers.erase(idleBuffers.begin() + best);
+        idleBufferBytes -= out->size;
+        return true;
+    }
+
+    SDL_GPUTransferBufferCreateInfo transfer_buffer_ci{};
+    transfer_buffer_ci.size = size;
+    transfer_buffer_ci.usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD;
+
+    out->buffer = SDL_CreateGPUTransferBuffer(device, &transfer_buffer_ci);
+    if (!out->buffer) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU,
+                     "create download buffer failed: %s", SDL_GetError());
+        return false;
+    }
+    out->size = size;
+    return true;
+}
+
+void ReadbackQueue::ReturnBuffer(const DownloadBuffer& buffer) {
+    if (idleBufferBytes + buffer.size > MaxIdleBufferBytes) {
+        SDL_ReleaseGPUTransferBuffer(device, buffer.buffer);
+        return;
+    }
+    idleBuffers.push_back(buffer);
+    idleBufferBytes += buffer.size;
+}
+
+void ReadbackQueue::FinishBatch(InFlightBatch& batch) {
+    SDL_ReleaseGPUFence(device, batch.fence);
+
+    for (auto& read : batch.reads) {
+        auto data = static_cast<const Uint8*>(
+            SDL_MapGPUTransferBuffer(device, read.dst.buffer, false));
+        if (data) {
+            if (read.callback) {
+                read.callback(data, read.size);
+            }
+            SDL_UnmapGPUTransferBuffer(device, read.dst.buffer);
+        } else {
+            SDL_LogError(SDL_LOG_CATEGORY_GPU,
+                         "map download buffer failed: %s", SDL_GetError());
+        }
+        ReturnBuffer(read.dst);
+    }
+}
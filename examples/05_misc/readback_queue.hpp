@@ -0,0 +1,67 @@
+#pragma once
+#include "SDL3/SDL.h"
+#include <functional>
+#include <vector>
+
+// Copies buffer/texture contents back to the CPU without stalling. Reads are
+// recorded into one copy pass on `Flush()`, which is submitted after the
+// frames that wrote the data, and their callbacks run from `Update()` once
+// the fence of that submission signaled, usually a few frames later.
+struct ReadbackQueue {
+    // `data` is only valid during the callback. Texture data is tightly
+    // packed, row by row.
+    using CompleteCallback = std::function<void(const Uint8* data, Uint32 size)>;
+
+    bool Init(SDL_GPUDevice* device);
+    void Destroy();
+
+    // `size` is the byte size of the region in the texture's format
+    bool ReadTexture(const SDL_GPUTextureRegion& region, Uint32 size,
+                     CompleteCallback callback);
+    bool ReadBuffer(const SDL_GPUBufferRegion& region,
+                    CompleteCallback callback);
+
+    // submit all pending reads
+    bool Flush();
+
+    // poll fences of submitted reads and call their callbacks
+    void Update();
+
+    // block until every submitted read finished, then call the callbacks
+    void WaitIdle();
+
+    bool HasPending() const { return !pending.empty(); }
+
+private:
+    struct DownloadBuffer {
+        SDL_GPUTransferBuffer* buffer{};
+        Uint32 size{};
+    };
+
+    struct PendingRead {
+        DownloadBuffer dst;
+        Uint32 size{};
+        // texture reads have `texture.texture` set, buffer reads
+        // `buffer.buffer`
+        SDL_GPUTextureRegion texture{};
+        SDL_GPUBufferRegion buffer{};
+        CompleteCallback callback;
+    };
+
+    struct InFlightBatch {
+        SDL_GPUFence* fence{};
+        std::vector<PendingRead> reads;
+    };
+
+    bool QueueRead(PendingRead& read, CompleteCallback callback);
+    bool AcquireBuffer(Uint32 size, DownloadBuffer* out);
+    void ReturnBuffer(const DownloadBuffer& buffer);
+    void FinishBatch(InFlightBatch& batch);
+
+    SDL_GPUDevice* device{};
+    std::vector<PendingRead> pending;
+    std::vector<InFlightBatch> inFlight;
+    // finished download buffers, reused for reads of a similar size
+    std::vector<DownloadBuffer> idleBuffers;
+    Uint64 idleBufferBytes = 0;
+};
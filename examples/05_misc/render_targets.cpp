@@ -0,0 +1,102 @@
+#include "render_targets.hpp"
+
+bool RenderTargets::Init(SDL_GPUDevice* device,
+                         SDL_GPUTextureFormat depth_format,
+                         SDL_GPUTextureFormat color_format) {
+    this->device = device;
+    depthFormat = depth_format;
+    colorFormat = color_format;
+    if (!SDL_GPUTextureSupportsFormat(device, depth_format,
+                                      SDL_GPU_TEXTURETYPE_2D,
+                                      SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET)) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU,
+                     "depth format %d is not supported as render target",
+                     depth_format);
+        return false;
+    }
+    if (color_format != SDL_GPU_TEXTUREFORMAT_INVALID &&
+        !SDL_GPUTextureSupportsFormat(device, color_format,
+                                      SDL_GPU_TEXTURETYPE_2D,
+                                      SDL_GPU_TEXTUREUSAGE_COLOR_TARGET |
+                                          SDL_GPU_TEXTUREUSAGE_SAMPLER)) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU,
+                     "color format %d is not supported as render target",
+                     color_format);
+        return false;
+    }
+    return true;
+}
+
+void RenderTargets::Destroy() {
+    Release();
+}
+
+bool RenderTargets::Resize(Uint32 width, Uint32 height) {
+    if (Matches(width, height) && depth) {
+        return true;
+    }
+    Release();
+
+    SDL_GPUTextureCreateInfo texture_ci{};
+    texture_ci.format = depthFormat;
+    texture_ci.width = width;
+    texture_ci.height = height;
+    texture_ci.layer_count_or_depth = 1;
+    texture_ci.num_levels = 1;
+    texture_ci.sample_count = SDL_GPU_SAMPLECOUNT_1;
+    texture_ci.type = SDL_GPU_TEXTURETYPE_2D;
+    texture_ci.usage = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET;
+
+    depth = SDL_CreateGPUTexture(device, &texture_ci);
+    if (!depth) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU, "create depth target failed: %s",
+                     SDL_GetError());
+        return false;
+    }
+
+    this->width = width;
+    this->height = height;
+    return true;
+}
+
+bool RenderTargets::EnsureColor() {
+    if (color) {
+        return true;
+    }
+    if (colorFormat == SDL_GPU_TEXTUREFORMAT_INVALID || !depth) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU,
+                     "color target needs a format and a size");
+        return false;
+    }
+
+    SDL_GPUTextureCreateInfo texture_ci{};
+    texture_ci.format = colorFormat;
+    texture_ci.width = width;
+    texture_ci.height = height;
+    texture_ci.layer_count_or_depth = 1;
+    texture_ci.num_levels = 1;
+    texture_ci.sample_count = SDL_GPU_SAMPLECOUNT_1;
+    texture_ci.type = SDL_GPU_TEXTURETYPE_2D;
+    texture_ci.usage =
+        SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER;
+    color = SDL_CreateGPUTexture(device, &texture_ci);
+    if (!color) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU, "create color target failed: %s",
+                     SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+void RenderTargets::Release() {
+    if (depth) {
+        SDL_ReleaseGPUTexture(device, depth);
+        depth = nullptr;
+    }
+    if (color) {
+        SDL_ReleaseGPUTexture(device, color);
+        color = nullptr;
+    }
+    width = 0;
+    height = 0;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "SDL3/SDL.h"
+
+// Textures whose size follows the swapchain, like the depth buffer. They are
+// created lazily on the first frame and only recreated when the swapchain
+// size changes, never every frame.
+struct RenderTargets {
+    // with a valid `color_format` an offscreen color target is available
+    // too, for rendering without a swapchain or for frames that are read
+    // back. It can be sampled and blitted from.
+    bool Init(SDL_GPUDevice* device, SDL_GPUTextureFormat depth_format,
+              SDL_GPUTextureFormat color_format = SDL_GPU_TEXTUREFORMAT_INVALID);
+    void Destroy();
+
+    // true when the targets already have this size
+    bool Matches(Uint32 width, Uint32 height) const {
+        return this->width == width && this->height == height;
+    }
+
+    // recreates the depth target at the new size and drops the color
+    // target. The old textures are only released after the GPU finished the
+    // frames still using them.
+    bool Resize(Uint32 width, Uint32 height);
+
+    // creates the color target at the current size unless it exists, so
+    // windows only pay for it once a frame is read back
+    bool EnsureColor();
+
+    SDL_GPUTexture* Depth() const { return depth; }
+    SDL_GPUTexture* Color() const { return color; }
+    SDL_GPUTextureFormat ColorFormat() const { return colorFormat; }
+    Uint32 Width() const { return width; }
+    Uint32 Height() const { return height; }
+
+private:
+    void Release();
+
+    SDL_GPUDevice* device{};
+    SDL_GPUTextureFormat depthFormat{};
+    SDL_GPUTextureFormat colorFormat{};
+    SDL_GPUTexture* depth{};
+    SDL_GPUTexture* color{};
+    Uint32 width{};
+    Uint32 height{};
+};
@@ -4,14 +4,28 @@ layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec2 inUV;
 
 layout(location = 0) out vec2 fragUV;
+layout(location = 1) out vec4 fragColor;
 
-layout(set = 1, binding = 0) uniform MVP {
-    mat4 proj;
-    mat4 view;
+struct Instance {
     mat4 model;
-} mvp;
+    vec4 color;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Instances {
+    Instance instances[];
+};
+
+layout(set = 1, binding = 0) uniform View {
+    mat4 viewProj;
+    // first instance of the draw, gl_InstanceIndex doesn't include the
+    // draw's first_instance on every backend
+    uint baseInstance;
+} view;
 
 void main() {
-    gl_Position = mvp.proj * mvp.view * mvp.model * vec4(inPosition, 1.0);
-    fragUV = inUV;
-}
\ No newline at end of file
+    Instance instance = instances[view.baseInstance + gl_InstanceIndex];
+    gl_Position = view.viewProj * instance.model * vec4(inPosition, 1.0);
+    // flip v, images are top row first
+    fragUV = vec2(inUV.x, 1.0 - inUV.y);
+    fragColor = instance.color;
+}
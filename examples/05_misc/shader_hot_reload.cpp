@@ -0,0 +1,200 @@
+#include "shader_hot_reload.hpp"
+#include "spirv_reflect.hpp"
+
+// how often the sources are checked for edits
+constexpr Sint32 PollIntervalMS = 250;
+
+bool ShaderHotReload::Init(SDL_GPUDevice* device, const char* glslc) {
+    this->device = device;
+    this->glslc = glslc;
+    mutex = SDL_CreateMutex();
+    wake = SDL_CreateCondition();
+    if (!mutex || !wake) {
+        SDL_LogError(SDL_LOG_CATEGORY_SYSTEM,
+                     "create shader hot reload sync objects failed: %s",
+                     SDL_GetError());
+        return false;
+    }
+
+    thread = SDL_CreateThread(WorkerMain, "shader hot reload", this);
+    if (!thread) {
+        SDL_LogError(SDL_LOG_CATEGORY_SYSTEM,
+                     "create shader hot reload thread failed: %s",
+                     SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+void ShaderHotReload::Destroy() {
+    if (mutex) {
+        SDL_LockMutex(mutex);
+        quit = true;
+        SDL_SignalCondition(wake);
+        SDL_UnlockMutex(mutex);
+    }
+    if (thread) {
+        SDL_WaitThread(thread, nullptr);
+        thread = nullptr;
+    }
+
+    for (auto& reloaded : finished) {
+        SDL_ReleaseGPUShader(device, reloaded.shader);
+    }
+    finished.clear();
+    sources.clear();
+
+    SDL_DestroyCondition(wake);
+    SDL_DestroyMutex(mutex);
+    wake = nullptr;
+    mutex = nullptr;
+}
+
+void ShaderHotReload::Watch(const char* source, SDL_GPUShaderStage stage) {
+    Source watched;
+    watched.path = source;
+    watched.stage = stage;
+    SDL_PathInfo info;
+    if (SDL_GetPathInfo(source, &info)) {
+        watched.modifyTime = info.modify_time;
+    } else {
+        SDL_LogError(SDL_LOG_CATEGORY_SYSTEM, "watch %s failed: %s", source,
+                     SDL_GetError());
+    }
+
+    SDL_LockMutex(mutex);
+    sources.push_back(std::move(watched));
+    SDL_UnlockMutex(mutex);
+}
+
+std::vector<ShaderHotReload::Reloaded> ShaderHotReload::Poll() {
+    std::vector<Reloaded> result;
+    SDL_LockMutex(mutex);
+    result.swap(finished);
+    SDL_UnlockMutex(mutex);
+    return result;
+}
+
+int ShaderHotReload::WorkerMain(void* userdata) {
+    auto reload = static_cast<ShaderHotReload*>(userdata);
+
+    SDL_LockMutex(reload->mutex);
+    while (true) {
+        SDL_WaitConditionTimeout(reload->wake, reload->mutex, PollIntervalMS);
+        if (reload->quit) {
+            break;
+        }
+
+        std::vector<Source> changed;
+        for (auto& source : reload->sources) {
+            SDL_PathInfo info;
+            if (SDL_GetPathInfo(source.path.c_str(), &info) &&
+                info.modify_time != source.modifyTime) {
+                source.modifyTime = info.modify_time;
+                changed.push_back(source);
+            }
+        }
+        SDL_UnlockMutex(reload->mutex);
+
+        // compiling takes a while, Poll() must not wait for it
+        for (auto& source : changed) {
+            Reloaded reloaded;
+            if (reload->Compile(source, &reloaded)) {
+                SDL_LockMutex(reload->mutex);
+                reload->finished.push_back(std::move(reloaded));
+                SDL_UnlockMutex(reload->mutex);
+            }
+        }
+
+        SDL_LockMutex(reload->mutex);
+    }
+    SDL_UnlockMutex(reload->mutex);
+    return 0;
+}
+
+bool ShaderHotReload::Compile(const Source& source, Reloaded* out) {
+    // next to the source instead of the build output, so the next regular
+    // build still sees its SPIR-V as out of date and recompiles
+    std::string output = source.path + ".hot.spv";
+    const char* args[] = {glslc.c_str(), source.path.c_str(), "-o",
+                          output.c_str(), nullptr};
+
+    SDL_PropertiesID props = SDL_CreateProperties();
+    SDL_SetPointerProperty(props, SDL_PROP_PROCESS_CREATE_ARGS_POINTER,
+                           (void*)args);
+    SDL_SetNumberProperty(props, SDL_PROP_PROCESS_CREATE_STDOUT_NUMBER,
+                          SDL_PROCESS_STDIO_APP);
+    SDL_SetBooleanProperty(
+        props, SDL_PROP_PROCESS_CREATE_STDERR_TO_STDOUT_BOOLEAN, true);
+    SDL_Process* process = SDL_CreateProcessWithProperties(props);
+    SDL_DestroyProperties(props);
+    if (!process) {
+        SDL_LogError(SDL_LOG_CATEGORY_SYSTEM, "run %s failed: %s",
+                     glslc.c_str(), SDL_GetError());
+        return false;
+    }
+
+    // reads until glslc exits, it only prints diagnostics
+    size_t log_size = 0;
+    int exit_code = -1;
+    char* log =
+        static_cast<char*>(SDL_ReadProcess(process, &log_size, &exit_code));
+    SDL_DestroyProcess(process);
+    if (exit_code != 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU, "compile %s failed:\n%s",
+                     source.path.c_str(), log ? log : "");
+        SDL_free(log);
+        return false;
+    }
+    SDL_free(log);
+
+    size_t code_size = 0;
+    void* code = SDL_LoadFile(output.c_str(), &code_size);
+    SDL_RemovePath(output.c_str());
+    if (!code) {
+        SDL_LogError(SDL_LOG_CATEGORY_SYSTEM, "read %s failed: %s",
+                     output.c_str(), SDL_GetError());
+        return false;
+    }
+
+    ShaderMeta meta;
+    std::string error;
+    if (!reflectSpirv(static_cast<const uint32_t*>(code), code_size / 4,
+                      &meta, &error)) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU, "reflect %s failed: %s",
+                     source.path.c_str(), error.c_str());
+        SDL_free(code);
+        return false;
+    }
+    ShaderMetaStage expected_stage = source.stage == SDL_GPU_SHADERSTAGE_VERTEX
+                                         ? ShaderMetaStage::Vertex
+                                         : ShaderMetaStage::Fragment;
+    if (meta.stage != expected_stage) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU, "%s changed its shader stage",
+                     source.path.c_str());
+        SDL_free(code);
+        return false;
+    }
+
+    SDL_GPUShaderCreateInfo ci{};
+    ci.code = static_cast<const Uint8*>(code);
+    ci.code_size = code_size;
+    ci.entrypoint = "main";
+    ci.format = SDL_GPU_SHADERFORMAT_SPIRV;
+    ci.num_samplers = meta.numSamplers;
+    ci.num_uniform_buffers = meta.numUniformBuffers;
+    ci.num_storage_buffers = meta.numStorageBuffers;
+    ci.num_storage_textures = meta.numStorageTextures;
+    ci.stage = source.stage;
+    out->shader = SDL_CreateGPUShader(device, &ci);
+    SDL_free(code);
+    if (!out->shader) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU,
+                     "create gpu shader from %s failed: %s",
+                     source.path.c_str(), SDL_GetError());
+        return false;
+    }
+    out->stage = source.stage;
+    out->meta = std::move(meta);
+    return true;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "SDL3/SDL.h"
+#include "shader_meta.hpp"
+#include <string>
+#include <vector>
+
+// Dev mode shader reloading. A worker thread polls the modification time of
+// the watched GLSL sources, recompiles changed ones with glslc in a child
+// process, reflects the SPIR-V and creates the new SDL_GPUShader, so the
+// render thread only picks finished shaders up and swaps them in.
+//
+// A failed compile is logged with glslc's output and the old shader stays,
+// saving the fixed source triggers the next attempt.
+struct ShaderHotReload {
+    struct Reloaded {
+        SDL_GPUShaderStage stage{};
+        SDL_GPUShader* shader{};
+        ShaderMeta meta;
+    };
+
+    // `glslc` is the compiler executable, searched in PATH without a
+    // directory
+    bool Init(SDL_GPUDevice* device, const char* glslc);
+    // stops watching and releases shaders nobody took
+    void Destroy();
+
+    // edits after this call reload the shader, the current file is assumed
+    // to match what is loaded
+    void Watch(const char* source, SDL_GPUShaderStage stage);
+
+    // takes the shaders rebuilt since the last call, the caller owns them
+    std::vector<Reloaded> Poll();
+
+private:
+    struct Source {
+        std::string path;
+        SDL_GPUShaderStage stage{};
+        SDL_Time modifyTime{};
+    };
+
+    static int SDLCALL WorkerMain(void* userdata);
+    bool Compile(const Source& source, Reloaded* out);
+
+    SDL_GPUDevice* device{};
+    std::string glslc;
+    SDL_Mutex* mutex{};
+    SDL_Condition* wake{};
+    SDL_Thread* thread{};
+    bool quit = false;
+    std::vector<Source> sources;
+    std::vector<Reloaded> finished;
+};
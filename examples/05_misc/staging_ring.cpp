@@ -0,0 +1,108 @@
+#include "staging_ring.hpp"
+
+static Uint64 alignUp(Uint64 value, Uint64 alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+bool StagingRing::Init(SDL_GPUDevice* device, Uint32 capacity) {
+    this->device = device;
+    this->capacity = capacity;
+
+    SDL_GPUTransferBufferCreateInfo transfer_buffer_ci{};
+    transfer_buffer_ci.size = capacity;
+    transfer_buffer_ci.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+
+    buffer = SDL_CreateGPUTransferBuffer(device, &transfer_buffer_ci);
+    if (!buffer) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU, "create staging ring failed: %s",
+                     SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+void StagingRing::Destroy() {
+    Unmap();
+    SDL_ReleaseGPUTransferBuffer(device, buffer);
+    buffer = nullptr;
+    batches.clear();
+    head = committed = tail = 0;
+}
+
+Uint8* StagingRing::Allocate(Uint32 size, Uint32 alignment,
+                             SDL_GPUTransferBuffer** out_buffer,
+                             Uint32* out_offset) {
+    if (!buffer || size > capacity) {
+        return nullptr;
+    }
+
+    Uint64 begin = alignUp(head, alignment);
+    // never split an allocation across the end of the buffer
+    if (begin % capacity + size > capacity) {
+        begin = alignUp(begin, capacity);
+    }
+    if (begin + size - tail > capacity) {
+        return nullptr;
+    }
+
+    if (!ptr) {
+        ptr = static_cast<Uint8*>(
+            SDL_MapGPUTransferBuffer(device, buffer, cycleOnMap));
+        if (!ptr) {
+            SDL_LogError(SDL_LOG_CATEGORY_GPU, "map staging ring failed: %s",
+                         SDL_GetError());
+            return nullptr;
+        }
+        cycleOnMap = false;
+    }
+
+    head = begin + size;
+
+    *out_buffer = buffer;
+    *out_offset = static_cast<Uint32>(begin % capacity);
+    return ptr + *out_offset;
+}
+
+void StagingRing::Unmap() {
+    if (ptr) {
+        SDL_UnmapGPUTransferBuffer(device, buffer);
+        ptr = nullptr;
+    }
+}
+
+Uint64 StagingRing::Commit() {
+    Batch batch;
+    batch.id = nextBatchId++;
+    batch.end = head;
+    batches.push_back(batch);
+    committed = head;
+    return batch.id;
+}
+
+void StagingRing::Release(Uint64 batch_id) {
+    for (auto& batch : batches) {
+        if (batch.id == batch_id) {
+            batch.done = true;
+            break;
+        }
+    }
+
+    // batches finish in submission order in practice, but only ever
+    // reclaim a contiguous range from the tail
+    while (!batches.empty() && batches.front().done) {
+        tail = batches.front().end;
+        batches.pop_front();
+    }
+}
+
+void StagingRing::Cycle() {
+    SDL_assert(!HasUncommitted());
+
+    Unmap();
+    cycleOnMap = true;
+
+    // the old backing memory stays alive inside SDL until the GPU is done
+    // with it, so all in-flight space can be treated as free
+    batches.clear();
+    head = committed = tail = alignUp(head, capacity);
+}
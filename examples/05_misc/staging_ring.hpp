@@ -0,0 +1,55 @@
+#pragma once
+#include "SDL3/SDL.h"
+#include <deque>
+
+// Ring allocator over one big upload transfer buffer.
+//
+// Allocations are grouped into batches by `Commit()`, and a batch's memory is
+// given back by `Release()` once the GPU has consumed it (the caller tracks
+// that with a fence). When the ring runs into memory the GPU is still reading,
+// `Cycle()` lets SDL swap in fresh backing memory instead of stalling.
+struct StagingRing {
+    bool Init(SDL_GPUDevice* device, Uint32 capacity);
+    void Destroy();
+
+    // returns nullptr if there is no free space left
+    Uint8* Allocate(Uint32 size, Uint32 alignment,
+                    SDL_GPUTransferBuffer** out_buffer, Uint32* out_offset);
+
+    // SDL wants transfer buffers unmapped before recording copies, the
+    // next `Allocate()` maps it again
+    void Unmap();
+
+    // close the current batch, the returned id is passed to `Release()`
+    Uint64 Commit();
+    void Release(Uint64 batch_id);
+
+    // drop the in-flight memory and continue in new backing memory, only
+    // valid when nothing uncommitted is left
+    void Cycle();
+
+    bool HasUncommitted() const { return head != committed; }
+
+    Uint32 Capacity() const { return capacity; }
+
+private:
+    struct Batch {
+        Uint64 id;
+        Uint64 end;
+        bool done = false;
+    };
+
+    SDL_GPUDevice* device{};
+    SDL_GPUTransferBuffer* buffer{};
+    Uint8* ptr{};
+    Uint32 capacity{};
+    bool cycleOnMap = false;
+
+    // positions grow monotonically, `position % capacity` is the offset
+    Uint64 head = 0;
+    Uint64 committed = 0;
+    Uint64 tail = 0;
+
+    Uint64 nextBatchId = 1;
+    std::deque<Batch> batches;
+};
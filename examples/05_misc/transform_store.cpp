@@ -0,0 +1,210 @@
+#include "transform_store.hpp"
+
+TransformStore::Handle TransformStore::Add(const glm::vec3& position,
+                                           const glm::quat& rotation,
+                                           const glm::vec3& scale) {
+    Handle handle = static_cast<Handle>(matrices.size());
+    positionX.push_back(position.x);
+    positionY.push_back(position.y);
+    positionZ.push_back(position.z);
+    rotationX.push_back(rotation.x);
+    rotationY.push_back(rotation.y);
+    rotationZ.push_back(rotation.z);
+    rotationW.push_back(rotation.w);
+    scaleX.push_back(scale.x);
+    scaleY.push_back(scale.y);
+    scaleZ.push_back(scale.z);
+    localCenters.push_back(glm::vec3(0));
+    localExtents.push_back(glm::vec3(0));
+    matrices.push_back(glm::mat4(1.0));
+    worldBounds.centerX.push_back(0);
+    worldBounds.centerY.push_back(0);
+    worldBounds.centerZ.push_back(0);
+    worldBounds.extentX.push_back(0);
+    worldBounds.extentY.push_back(0);
+    worldBounds.extentZ.push_back(0);
+    dirtyGroups.resize((matrices.size() + 3) / 4);
+    MarkDirty(handle);
+    return handle;
+}
+
+void TransformStore::SetPosition(Handle handle, const glm::vec3& p) {
+    positionX[handle] = p.x;
+    positionY[handle] = p.y;
+    positionZ[handle] = p.z;
+    MarkDirty(handle);
+}
+
+void TransformStore::SetRotation(Handle handle, const glm::quat& q) {
+    rotationX[handle] = q.x;
+    rotationY[handle] = q.y;
+    rotationZ[handle] = q.z;
+    rotationW[handle] = q.w;
+    MarkDirty(handle);
+}
+
+void TransformStore::SetScale(Handle handle, const glm::vec3& s) {
+    scaleX[handle] = s.x;
+    scaleY[handle] = s.y;
+    scaleZ[handle] = s.z;
+    MarkDirty(handle);
+}
+
+void TransformStore::SetLocalBounds(Handle handle, const glm::vec3& center,
+                                    const glm::vec3& extent) {
+    localCenters[handle] = center;
+    localExtents[handle] = extent;
+    MarkDirty(handle);
+}
+
+void TransformStore::MarkDirty(Handle handle) {
+    dirtyGroups[handle / 4] = true;
+    anyDirty = true;
+}
+
+// one transform at a time, for the tail of the streams and for targets
+// without SSE
+static void composeScalar(const float* px, const float* py, const float* pz,
+                          const float* qx, const float* qy, const float* qz,
+                          const float* qw, const float* sx, const float* sy,
+                          const float* sz, size_t count, glm::mat4* out) {
+    for (size_t i = 0; i < count; i++) {
+        float xx = qx[i] * qx[i], yy = qy[i] * qy[i], zz = qz[i] * qz[i];
+        float xy = qx[i] * qy[i], xz = qx[i] * qz[i], yz = qy[i] * qz[i];
+        float wx = qw[i] * qx[i], wy = qw[i] * qy[i], wz = qw[i] * qz[i];
+
+        glm::mat4& m = out[i];
+        m[0] = glm::vec4(1 - 2 * (yy + zz), 2 * (xy + wz), 2 * (xz - wy), 0) * sx[i];
+        m[1] = glm::vec4(2 * (xy - wz), 1 - 2 * (xx + zz), 2 * (yz + wx), 0) * sy[i];
+        m[2] = glm::vec4(2 * (xz + wy), 2 * (yz - wx), 1 - 2 * (xx + yy), 0) * sz[i];
+        m[3] = glm::vec4(px[i], py[i], pz[i], 1);
+    }
+}
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+
+// Four transforms per call, every lane of a register belongs to another
+// transform. The finished columns are transposed into the four matrices.
+static void composeSSE(const float* px, const float* py, const float* pz,
+                       const float* qx, const float* qy, const float* qz,
+                       const float* qw, const float* sx, const float* sy,
+                       const float* sz, glm::mat4* out) {
+    __m128 x = _mm_loadu_ps(qx);
+    __m128 y = _mm_loadu_ps(qy);
+    __m128 z = _mm_loadu_ps(qz);
+    __m128 w = _mm_loadu_ps(qw);
+
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 two = _mm_set1_ps(2.0f);
+    __m128 x2 = _mm_mul_ps(x, two);
+    __m128 y2 = _mm_mul_ps(y, two);
+    __m128 z2 = _mm_mul_ps(z, two);
+
+    __m128 xx = _mm_mul_ps(x, x2);
+    __m128 yy = _mm_mul_ps(y, y2);
+    __m128 zz = _mm_mul_ps(z, z2);
+    __m128 xy = _mm_mul_ps(x, y2);
+    __m128 xz = _mm_mul_ps(x, z2);
+    __m128 yz = _mm_mul_ps(y, z2);
+    __m128 wx = _mm_mul_ps(w, x2);
+    __m128 wy = _mm_mul_ps(w, y2);
+    __m128 wz = _mm_mul_ps(w, z2);
+
+    __m128 scale_x = _mm_loadu_ps(sx);
+    __m128 scale_y = _mm_loadu_ps(sy);
+    __m128 scale_z = _mm_loadu_ps(sz);
+
+    // rows of the transposes are the matrix columns, the 4th row is w
+    __m128 c0x = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), scale_x);
+    __m128 c0y = _mm_mul_ps(_mm_add_ps(xy, wz), scale_x);
+    __m128 c0z = _mm_mul_ps(_mm_sub_ps(xz, wy), scale_x);
+    __m128 c0w = _mm_setzero_ps();
+
+    __m128 c1x = _mm_mul_ps(_mm_sub_ps(xy, wz), scale_y);
+    __m128 c1y = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), scale_y);
+    __m128 c1z = _mm_mul_ps(_mm_add_ps(yz, wx), scale_y);
+    __m128 c1w = _mm_setzero_ps();
+
+    __m128 c2x = _mm_mul_ps(_mm_add_ps(xz, wy), scale_z);
+    __m128 c2y = _mm_mul_ps(_mm_sub_ps(yz, wx), scale_z);
+    __m128 c2z = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), scale_z);
+    __m128 c2w = _mm_setzero_ps();
+
+    __m128 c3x = _mm_loadu_ps(px);
+    __m128 c3y = _mm_loadu_ps(py);
+    __m128 c3z = _mm_loadu_ps(pz);
+    __m128 c3w = one;
+
+    _MM_TRANSPOSE4_PS(c0x, c0y, c0z, c0w);
+    _MM_TRANSPOSE4_PS(c1x, c1y, c1z, c1w);
+    _MM_TRANSPOSE4_PS(c2x, c2y, c2z, c2w);
+    _MM_TRANSPOSE4_PS(c3x, c3y, c3z, c3w);
+
+    // after the transposes register i of each column holds transform i
+    __m128 columns[4][4] = {
+        {c0x, c1x, c2x, c3x},
+        {c0y, c1y, c2y, c3y},
+        {c0z, c1z, c2z, c3z},
+        {c0w, c1w, c2w, c3w},
+    };
+    for (int i = 0; i < 4; i++) {
+        float* m = &out[i][0][0];
+        for (int c = 0; c < 4; c++) {
+            _mm_storeu_ps(m + c * 4, columns[i][c]);
+        }
+    }
+}
+
+#endif
+
+// the world box encloses the transformed local box: its center is moved by
+// the matrix, and each world axis gets the local extents projected onto it
+void TransformStore::UpdateWorldBounds(size_t first, size_t count) {
+    for (size_t i = first; i < first + count; i++) {
+        const glm::mat4& m = matrices[i];
+        glm::vec3 center = glm::vec3(m * glm::vec4(localCenters[i], 1));
+        glm::vec3 extent = glm::abs(glm::vec3(m[0])) * localExtents[i].x +
+                           glm::abs(glm::vec3(m[1])) * localExtents[i].y +
+                           glm::abs(glm::vec3(m[2])) * localExtents[i].z;
+
+        worldBounds.centerX[i] = center.x;
+        worldBounds.centerY[i] = center.y;
+        worldBounds.centerZ[i] = center.z;
+        worldBounds.extentX[i] = extent.x;
+        worldBounds.extentY[i] = extent.y;
+        worldBounds.extentZ[i] = extent.z;
+    }
+}
+
+void TransformStore::Update() {
+    if (!anyDirty) {
+        return;
+    }
+    anyDirty = false;
+
+    size_t count = matrices.size();
+    for (size_t group = 0; group < dirtyGroups.size(); group++) {
+        if (!dirtyGroups[group]) {
+            continue;
+        }
+        dirtyGroups[group] = false;
+
+        size_t i = group * 4;
+        size_t n = SDL_min(count - i, size_t(4));
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+        if (n == 4) {
+            composeSSE(&positionX[i], &positionY[i], &positionZ[i],
+                       &rotationX[i], &rotationY[i], &rotationZ[i],
+                       &rotationW[i], &scaleX[i], &scaleY[i], &scaleZ[i],
+                       &matrices[i]);
+            UpdateWorldBounds(i, n);
+            continue;
+        }
+#endif
+        composeScalar(&positionX[i], &positionY[i], &positionZ[i],
+                      &rotationX[i], &rotationY[i], &rotationZ[i],
+                      &rotationW[i], &scaleX[i], &scaleY[i], &scaleZ[i], n,
+                      &matrices[i]);
+        UpdateWorldBounds(i, n);
+    }
+}
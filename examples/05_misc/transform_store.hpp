@@ -0,0 +1,59 @@
+#pragma once
+#include "SDL3/SDL.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+#include <vector>
+
+// Transforms stored as separate position, rotation and scale streams
+// (structure of arrays). `Update()` walks the streams 4 transforms at a time
+// and composes their model matrices with SSE, only touching groups that
+// contain a changed transform.
+struct TransformStore {
+    using Handle = Uint32;
+
+    // world space axis aligned boxes, one per transform
+    struct WorldBounds {
+        std::vector<float> centerX, centerY, centerZ;
+        std::vector<float> extentX, extentY, extentZ;
+    };
+
+    Handle Add(const glm::vec3& position, const glm::quat& rotation,
+               const glm::vec3& scale);
+
+    void SetPosition(Handle handle, const glm::vec3& p);
+    void SetRotation(Handle handle, const glm::quat& q);
+    void SetScale(Handle handle, const glm::vec3& s);
+
+    // box around the object in its local space, empty by default. The world
+    // space box is rebuilt together with the matrix.
+    void SetLocalBounds(Handle handle, const glm::vec3& center,
+                        const glm::vec3& extent);
+
+    // valid after `Update()`
+    const glm::mat4& GetMat(Handle handle) const { return matrices[handle]; }
+
+    // valid after `Update()`
+    const WorldBounds& GetWorldBounds() const { return worldBounds; }
+
+    // rebuild the model matrices (translate * rotate * scale) of all changed
+    // transforms
+    void Update();
+
+    size_t Size() const { return matrices.size(); }
+
+private:
+    void MarkDirty(Handle handle);
+    void UpdateWorldBounds(size_t first, size_t count);
+
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+    std::vector<float> scaleX, scaleY, scaleZ;
+
+    std::vector<glm::vec3> localCenters, localExtents;
+
+    std::vector<glm::mat4> matrices;
+    WorldBounds worldBounds;
+    // one flag per group of 4 transforms
+    std::vector<Uint8> dirtyGroups;
+    bool anyDirty = false;
+};
@@ -0,0 +1,333 @@
+#include "upload_queue.hpp"
+
+// D3D12 wants texture data placed at 512 bytes, which also satisfies the
+// texel block alignment of every format we upload
+constexpr Uint32 TextureUploadAlignment = 512;
+constexpr Uint32 BufferUploadAlignment = 16;
+
+// idle pooled transfer buffers beyond this are released
+constexpr Uint64 MaxIdleBufferBytes = 128 * 1024 * 1024;
+
+bool UploadQueue::Init(SDL_GPUDevice* device, Uint32 staging_size) {
+    this->device = device;
+    return staging.Init(device, staging_size);
+}
+
+void UploadQueue::Destroy() {
+    WaitIdle();
+
+    for (auto& buffer : batchBuffers) {
+        if (buffer.mapped) {
+            SDL_UnmapGPUTransferBuffer(device, buffer.buffer);
+        }
+        SDL_ReleaseGPUTransferBuffer(device, buffer.buffer);
+    }
+    batchBuffers.clear();
+    for (auto& buffer : idleBuffers) {
+        SDL_ReleaseGPUTransferBuffer(device, buffer.buffer);
+    }
+    idleBuffers.clear();
+    idleBufferBytes = 0;
+    staging.Destroy();
+    pendingBuffers.clear();
+    pendingTextures.clear();
+    pendingMipmaps.clear();
+}
+
+bool UploadQueue::UploadToBuffer(const SDL_GPUBufferRegion& region,
+                                 const void* data) {
+    PendingBufferUpload upload;
+    Uint8* ptr;
+    if (!AllocateStaging(region.size, BufferUploadAlignment,
+                         &upload.src.transfer_buffer, &upload.src.offset,
+                         &ptr)) {
+        return false;
+    }
+    memcpy(ptr, data, region.size);
+    pendingBytes += region.size;
+
+    upload.dst = region;
+    pendingBuffers.push_back(upload);
+    return true;
+}
+
+bool UploadQueue::UploadToTexture(const SDL_GPUTextureRegion& region,
+                                  const void* data, Uint32 size) {
+    PendingTextureUpload upload;
+    Uint8* ptr;
+    if (!AllocateStaging(size, TextureUploadAlignment,
+                         &upload.src.transfer_buffer, &upload.src.offset,
+                         &ptr)) {
+        return false;
+    }
+    memcpy(ptr, data, size);
+    pendingBytes += size;
+
+    // tightly packed, for block compressed formats too
+    upload.src.pixels_per_row = 0;
+    upload.src.rows_per_layer = 0;
+    upload.dst = region;
+    pendingTextures.push_back(upload);
+    return true;
+}
+
+bool UploadQueue::BeginMappedUpload(Uint32 size, MappedUpload* out) {
+    PooledBuffer buffer;
+    if (!AcquirePooledBuffer(size, &buffer, &out->ptr)) {
+        return false;
+    }
+    out->buffer = buffer.buffer;
+    out->size = buffer.size;
+    return true;
+}
+
+void UploadQueue::SubmitMappedTexture(const MappedUpload& upload,
+                                      const SDL_GPUTextureRegion& region) {
+    Uint32 offset = 0;
+    SubmitMappedTextures(upload, &region, &offset, 1);
+}
+
+void UploadQueue::SubmitMappedTextures(const MappedUpload& upload,
+                                       const SDL_GPUTextureRegion* regions,
+                                       const Uint32* offsets, int count) {
+    SDL_UnmapGPUTransferBuffer(device, upload.buffer);
+
+    PooledBuffer buffer;
+    buffer.buffer = upload.buffer;
+    buffer.size = upload.size;
+    batchBuffers.push_back(buffer);
+    pendingBytes += upload.size;
+
+    for (int i = 0; i < count; i++) {
+        PendingTextureUpload texture_upload;
+        texture_upload.src.transfer_buffer = upload.buffer;
+        texture_upload.src.offset = offsets[i];
+        texture_upload.src.pixels_per_row = 0;
+        texture_upload.src.rows_per_layer = 0;
+        texture_upload.dst = regions[i];
+        pendingTextures.push_back(texture_upload);
+    }
+}
+
+void UploadQueue::CancelMappedUpload(const MappedUpload& upload) {
+    SDL_UnmapGPUTransferBuffer(device, upload.buffer);
+
+    PooledBuffer buffer;
+    buffer.buffer = upload.buffer;
+    buffer.size = upload.size;
+    ReturnPooledBuffer(buffer);
+}
+
+void UploadQueue::GenerateMipmaps(SDL_GPUTexture* texture) {
+    pendingMipmaps.push_back(texture);
+}
+
+bool UploadQueue::Flush(CompleteCallback callback) {
+    if (!HasPending()) {
+        if (!callback) {
+            return true;
+        }
+        if (inFlight.empty()) {
+            callback();
+            return true;
+        }
+        // batches finish in submission order, so the newest one finishing
+        // means every earlier upload landed too
+        CompleteCallback& last = inFlight.back().callback;
+        last = [first = std::move(last), then = std::move(callback)]() {
+            if (first) {
+                first();
+            }
+            then();
+        };
+        return true;
+    }
+
+    InFlightBatch batch;
+    // set before anything can fail, `FinishBatch()` runs it either way
+    batch.callback = std::move(callback);
+    staging.Unmap();
+    batch.stagingBatch = staging.Commit();
+    for (auto& buffer : batchBuffers) {
+        if (buffer.mapped) {
+            SDL_UnmapGPUTransferBuffer(device, buffer.buffer);
+            buffer.mapped = false;
+        }
+    }
+    batch.buffers = std::move(batchBuffers);
+    batchBuffers.clear();
+
+    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer(device);
+    if (!cmd) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU, "acquire upload command buffer failed: %s",
+                     SDL_GetError());
+        pendingBuffers.clear();
+        pendingTextures.clear();
+        pendingMipmaps.clear();
+        pendingBytes = 0;
+        FinishBatch(batch);
+        return false;
+    }
+
+    SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass(cmd);
+    for (auto& upload : pendingBuffers) {
+        SDL_UploadToGPUBuffer(copy_pass, &upload.src, &upload.dst, false);
+    }
+    for (auto& upload : pendingTextures) {
+        SDL_UploadToGPUTexture(copy_pass, &upload.src, &upload.dst, false);
+    }
+    SDL_EndGPUCopyPass(copy_pass);
+
+    // SDL blits level by level in its own render passes, after the copy pass
+    // so level 0 already holds the uploaded pixels
+    for (auto texture : pendingMipmaps) {
+        SDL_GenerateMipmapsForGPUTexture(cmd, texture);
+    }
+
+    pendingBuffers.clear();
+    pendingTextures.clear();
+    pendingMipmaps.clear();
+    submittedBytes += pendingBytes;
+    pendingBytes = 0;
+
+    batch.fence = SDL_SubmitGPUCommandBufferAndAcquireFence(cmd);
+    if (!batch.fence) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU, "submit upload command buffer failed: %s",
+                     SDL_GetError());
+        FinishBatch(batch);
+        return false;
+    }
+
+    inFlight.push_back(std::move(batch));
+    return true;
+}
+
+void UploadQueue::Update() {
+    size_t i = 0;
+    while (i < inFlight.size()) {
+        if (SDL_QueryGPUFence(device, inFlight[i].fence)) {
+            // callbacks may flush again, so take the batch out first
+            InFlightBatch batch = std::move(inFlight[i]);
+            inFlight.erase(inFlight.begin() + i);
+            FinishBatch(batch);
+        } else {
+            i++;
+        }
+    }
+}
+
+void UploadQueue::WaitIdle() {
+    while (!inFlight.empty()) {
+        InFlightBatch batch = std::move(inFlight.front());
+        inFlight.erase(inFlight.begin());
+        SDL_WaitForGPUFences(device, true, &batch.fence, 1);
+        FinishBatch(batch);
+    }
+}
+
+bool UploadQueue::AllocateStaging(Uint32 size, Uint32 alignment,
+                                  SDL_GPUTransferBuffer** out_buffer,
+                                  Uint32* out_offset, Uint8** out_ptr) {
+    if (size <= staging.Capacity()) {
+        *out_ptr = staging.Allocate(size, alignment, out_buffer, out_offset);
+        if (!*out_ptr) {
+            // give back whatever the GPU already consumed
+            Update();
+            *out_ptr =
+                staging.Allocate(size, alignment, out_buffer, out_offset);
+        }
+        if (!*out_ptr && staging.HasUncommitted()) {
+            // the ring is full of our own pending data, submit it so the
+            // ring is allowed to cycle
+            Flush();
+            *out_ptr =
+                staging.Allocate(size, alignment, out_buffer, out_offset);
+        }
+        if (!*out_ptr) {
+            // the GPU still reads the space we need, continue in fresh
+            // backing memory instead of waiting for it
+            staging.Cycle();
+            *out_ptr =
+                staging.Allocate(size, alignment, out_buffer, out_offset);
+        }
+        return *out_ptr != nullptr;
+    }
+
+    PooledBuffer buffer;
+    if (!AcquirePooledBuffer(size, &buffer, out_ptr)) {
+        return false;
+    }
+    batchBuffers.push_back(buffer);
+
+    *out_buffer = buffer.buffer;
+    *out_offset = 0;
+    return true;
+}
+
+bool UploadQueue::AcquirePooledBuffer(Uint32 size, PooledBuffer* out,
+                                      Uint8** out_ptr) {
+    // smallest idle buffer that fits, but don't waste more than half of it
+    int best = -1;
+    for (int i = 0; i < (int)idleBuffers.size(); i++) {
+        Uint32 idle_size = idleBuffers[i].size;
+        if (idle_size >= size && idle_size / 2 <= size &&
+            (best < 0 || idle_size < idleBuffers[best].size)) {
+            best = i;
+        }
+    }
+
+    if (best >= 0) {
+        *out = idleBuffers[best];
+        idleBuffers.erase(idleBuffers.begin() + best);
+        idleBufferBytes -= out->size;
+    } else {
+        SDL_GPUTransferBufferCreateInfo transfer_buffer_ci{};
+        transfer_buffer_ci.size = size;
+        transfer_buffer_ci.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+
+        out->buffer = SDL_CreateGPUTransferBuffer(device, &transfer_buffer_ci);
+        if (!out->buffer) {
+            SDL_LogError(SDL_LOG_CATEGORY_GPU,
+                         "create staging buffer failed: %s", SDL_GetError());
+            return false;
+        }
+        out->size = size;
+    }
+
+    // idle buffers are only pooled after the GPU finished reading them, so
+    // no cycling is needed
+    *out_ptr = static_cast<Uint8*>(
+        SDL_MapGPUTransferBuffer(device, out->buffer, false));
+    if (!*out_ptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU, "map staging buffer failed: %s",
+                     SDL_GetError());
+        SDL_ReleaseGPUTransferBuffer(device, out->buffer);
+        return false;
+    }
+    out->mapped = true;
+    return true;
+}
+
+void UploadQueue::ReturnPooledBuffer(const PooledBuffer& buffer) {
+    if (idleBufferBytes + buffer.size > MaxIdleBufferBytes) {
+        SDL_ReleaseGPUTransferBuffer(device, buffer.buffer);
+        return;
+    }
+    idleBuffers.push_back(buffer);
+    idleBuffers.back().mapped = false;
+    idleBufferBytes += buffer.size;
+}
+
+void UploadQueue::FinishBatch(InFlightBatch& batch) {
+    staging.Release(batch.stagingBatch);
+    for (auto& buffer : batch.buffers) {
+        ReturnPooledBuffer(buffer);
+    }
+    if (batch.fence) {
+        SDL_ReleaseGPUFence(device, batch.fence);
+    }
+
+    if (batch.callback) {
+        batch.callback();
+    }
+}
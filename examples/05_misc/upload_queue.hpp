@@ -0,0 +1,116 @@
+#pragma once
+#include "SDL3/SDL.h"
+#include "staging_ring.hpp"
+#include <functional>
+#include <vector>
+
+// Collects buffer/texture uploads and records them into one copy pass, so
+// loading N resources costs one command buffer submission instead of N.
+// Staging memory comes from a persistent `StagingRing`, so uploading every
+// frame doesn't create or release any transfer buffer.
+struct UploadQueue {
+    using CompleteCallback = std::function<void()>;
+
+    // staging memory handed out by `BeginMappedUpload()`
+    struct MappedUpload {
+        SDL_GPUTransferBuffer* buffer{};
+        Uint32 size{};
+        Uint8* ptr{};
+    };
+
+    bool Init(SDL_GPUDevice* device, Uint32 staging_size);
+    void Destroy();
+
+    bool UploadToBuffer(const SDL_GPUBufferRegion& region, const void* data);
+    bool UploadToTexture(const SDL_GPUTextureRegion& region, const void* data,
+                         Uint32 size);
+
+    // Staging memory which stays mapped until it is submitted or canceled,
+    // so e.g. a worker thread can decode into it while other uploads are
+    // flushed. The ring is unmapped on every flush, so this memory comes
+    // from a pool of separate transfer buffers instead.
+    bool BeginMappedUpload(Uint32 size, MappedUpload* out);
+    void SubmitMappedTexture(const MappedUpload& upload,
+                             const SDL_GPUTextureRegion& region);
+    // several regions packed in one upload, e.g. every level of a texture.
+    // The data of `regions[i]` starts at `offsets[i]`, which must be a
+    // multiple of 512 for D3D12.
+    void SubmitMappedTextures(const MappedUpload& upload,
+                              const SDL_GPUTextureRegion* regions,
+                              const Uint32* offsets, int count);
+    void CancelMappedUpload(const MappedUpload& upload);
+
+    // fill mip levels 1..n from level 0 once the pending uploads landed,
+    // `texture` needs `SDL_GPU_TEXTUREUSAGE_COLOR_TARGET` and 2+ levels
+    void GenerateMipmaps(SDL_GPUTexture* texture);
+
+    // submit all pending uploads, `callback` is called from `Update()` once
+    // the GPU finished them and every earlier batch. It is called right away
+    // when nothing is pending or in flight, or when submitting fails.
+    bool Flush(CompleteCallback callback = {});
+
+    // poll fences of submitted uploads, call their callbacks and release
+    // staging memory
+    void Update();
+
+    // block until every submitted upload finished
+    void WaitIdle();
+
+    // bytes submitted by `Flush()` since the last call
+    Uint64 TakeSubmittedBytes() {
+        Uint64 bytes = submittedBytes;
+        submittedBytes = 0;
+        return bytes;
+    }
+
+    bool HasPending() const {
+        return !pendingBuffers.empty() || !pendingTextures.empty() ||
+               !pendingMipmaps.empty();
+    }
+
+private:
+    struct PendingBufferUpload {
+        SDL_GPUTransferBufferLocation src;
+        SDL_GPUBufferRegion dst;
+    };
+
+    struct PendingTextureUpload {
+        SDL_GPUTextureTransferInfo src;
+        SDL_GPUTextureRegion dst;
+    };
+
+    // transfer buffer outside of the ring, for uploads that don't fit into
+    // it and for mapped uploads
+    struct PooledBuffer {
+        SDL_GPUTransferBuffer* buffer{};
+        Uint32 size{};
+        bool mapped = false;
+    };
+
+    struct InFlightBatch {
+        SDL_GPUFence* fence{};
+        Uint64 stagingBatch{};
+        std::vector<PooledBuffer> buffers;
+        CompleteCallback callback;
+    };
+
+    bool AllocateStaging(Uint32 size, Uint32 alignment,
+                         SDL_GPUTransferBuffer** out_buffer,
+                         Uint32* out_offset, Uint8** out_ptr);
+    bool AcquirePooledBuffer(Uint32 size, PooledBuffer* out, Uint8** out_ptr);
+    void ReturnPooledBuffer(const PooledBuffer& buffer);
+    void FinishBatch(InFlightBatch& batch);
+
+    SDL_GPUDevice* device{};
+    StagingRing staging;
+    // pooled buffers read by the not yet flushed uploads
+    std::vector<PooledBuffer> batchBuffers;
+    std::vector<PooledBuffer> idleBuffers;
+    Uint64 idleBufferBytes = 0;
+    std::vector<PendingBufferUpload> pendingBuffers;
+    std::vector<PendingTextureUpload> pendingTextures;
+    std::vector<SDL_GPUTexture*> pendingMipmaps;
+    std::vector<InFlightBatch> inFlight;
+    Uint64 pendingBytes = 0;
+    Uint64 submittedBytes = 0;
+};
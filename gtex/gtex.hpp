@@ -0,0 +1,120 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Container for cooked textures, written by `tools/texture_cooker` and read
+// at runtime.
+//
+// Layout:
+//   GTexHeader
+//   GTexLevel[header.levelCount]
+//   level data, each level starts at a multiple of GTEX_DATA_ALIGNMENT
+//
+// Level data is laid out like the GPU upload wants it: rows tightly packed,
+// level 0 first, so a level can be copied to staging memory as one block.
+// Block compressed levels store rows of 4x4 blocks, padded up to whole
+// blocks at the right and bottom edge.
+
+constexpr char GTEX_MAGIC[4] = {'G', 'T', 'E', 'X'};
+constexpr uint32_t GTEX_VERSION = 1;
+constexpr uint32_t GTEX_DATA_ALIGNMENT = 512;
+
+enum class GTexFormat : uint32_t {
+    RGBA8 = 0,
+    // opaque color, 8 bytes per block
+    BC1 = 1,
+    // color + alpha, 16 bytes per block. The cooker only writes mode 6
+    // blocks, see gtex_bc.hpp
+    BC7 = 2,
+};
+
+struct GTexHeader {
+    char magic[4];
+    uint32_t version;
+    GTexFormat format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t levelCount;
+};
+
+struct GTexLevel {
+    uint32_t width;
+    uint32_t height;
+    // from the beginning of the file
+    uint64_t offset;
+    uint64_t size;
+};
+
+// 1 for uncompressed formats
+inline uint32_t gtexBlockDim(GTexFormat format) {
+    return format == GTexFormat::RGBA8 ? 1 : 4;
+}
+
+// bytes per pixel for uncompressed formats, per block otherwise
+inline uint32_t gtexBlockSize(GTexFormat format) {
+    switch (format) {
+        case GTexFormat::RGBA8:
+            return 4;
+        case GTexFormat::BC1:
+            return 8;
+        case GTexFormat::BC7:
+            return 16;
+    }
+    return 0;
+}
+
+inline uint64_t gtexLevelSize(GTexFormat format, uint32_t w, uint32_t h) {
+    uint32_t dim = gtexBlockDim(format);
+    return uint64_t((w + dim - 1) / dim) * ((h + dim - 1) / dim) *
+           gtexBlockSize(format);
+}
+
+// mip levels of a full chain down to 1x1
+inline uint32_t gtexMaxLevelCount(uint32_t w, uint32_t h) {
+    uint32_t count = 1;
+    for (uint32_t dim = w > h ? w : h; dim > 1; dim >>= 1) {
+        count++;
+    }
+    return count;
+}
+
+// checks that the header, level table and all level data lie inside `size`
+// bytes, that the levels form a mip chain and that every level starts at an
+// aligned offset that fits in 32 bits, which is what GPU uploads take.
+// Returns the level table or nullptr if the file is broken.
+inline const GTexLevel* gtexValidate(const void* data, size_t size) {
+    if (size < sizeof(GTexHeader)) {
+        return nullptr;
+    }
+
+    auto header = static_cast<const GTexHeader*>(data);
+    if (memcmp(header->magic, GTEX_MAGIC, sizeof(GTEX_MAGIC)) != 0 ||
+        header->version != GTEX_VERSION ||
+        gtexBlockSize(header->format) == 0 || header->width == 0 ||
+        header->height == 0 || header->levelCount == 0 ||
+        header->levelCount >
+            gtexMaxLevelCount(header->width, header->height)) {
+        return nullptr;
+    }
+
+    if (size < sizeof(GTexHeader) + header->levelCount * sizeof(GTexLevel)) {
+        return nullptr;
+    }
+
+    auto levels = reinterpret_cast<const GTexLevel*>(header + 1);
+    for (uint32_t i = 0; i < header->levelCount; i++) {
+        const GTexLevel& level = levels[i];
+        uint32_t w = header->width >> i;
+        uint32_t h = header->height >> i;
+        if (level.width != (w > 1 ? w : 1) || level.height != (h > 1 ? h : 1) ||
+            level.size !=
+                gtexLevelSize(header->format, level.width, level.height) ||
+            level.offset % GTEX_DATA_ALIGNMENT != 0 ||
+            level.offset > UINT32_MAX || level.size > UINT32_MAX ||
+            level.offset > size || level.size > size - level.offset) {
+            return nullptr;
+        }
+    }
+    return levels;
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include "gtex.hpp"
+#include <cstdint>
+#include <cstring>
+
+// CPU decoders for the block compressed formats the cooker writes, used when
+// the GPU can't sample them. The block functions decode one 4x4 block into
+// 16 RGBA8 pixels, row by row.
+
+// BC7 mode 6 interpolation weights for 4 bit indices
+constexpr uint8_t GTEX_BC7_WEIGHTS4[16] = {0,  4,  9,  13, 17, 21, 26, 30,
+                                           34, 38, 43, 47, 51, 55, 60, 64};
+
+inline void gtexUnpack565(uint16_t c, uint8_t out[4]) {
+    uint8_t r = (c >> 11) & 31;
+    uint8_t g = (c >> 5) & 63;
+    uint8_t b = c & 31;
+    out[0] = uint8_t((r << 3) | (r >> 2));
+    out[1] = uint8_t((g << 2) | (g >> 4));
+    out[2] = uint8_t((b << 3) | (b >> 2));
+    out[3] = 255;
+}
+
+inline void gtexDecodeBC1Block(const uint8_t block[8], uint8_t out[64]) {
+    uint16_t c0 = uint16_t(block[0] | (block[1] << 8));
+    uint16_t c1 = uint16_t(block[2] | (block[3] << 8));
+
+    uint8_t palette[4][4];
+    gtexUnpack565(c0, palette[0]);
+    gtexUnpack565(c1, palette[1]);
+    for (int c = 0; c < 3; c++) {
+        if (c0 > c1) {
+            palette[2][c] = uint8_t((2 * palette[0][c] + palette[1][c] + 1) / 3);
+            palette[3][c] = uint8_t((palette[0][c] + 2 * palette[1][c] + 1) / 3);
+        } else {
+            palette[2][c] = uint8_t((palette[0][c] + palette[1][c]) / 2);
+            palette[3][c] = 0;
+        }
+    }
+    palette[2][3] = 255;
+    palette[3][3] = c0 > c1 ? 255 : 0;
+
+    uint32_t indices = uint32_t(block[4]) | (uint32_t(block[5]) << 8) |
+                       (uint32_t(block[6]) << 16) | (uint32_t(block[7]) << 24);
+    for (int i = 0; i < 16; i++) {
+        memcpy(out + i * 4, palette[(indices >> (i * 2)) & 3], 4);
+    }
+}
+
+// only mode 6 (one subset, 7 bit RGBA endpoints with p-bits, 4 bit indices)
+// is supported, blocks in other modes decode to transparent black
+inline void gtexDecodeBC7Block(const uint8_t block[16], uint8_t out[64]) {
+    uint64_t lo, hi;
+    memcpy(&lo, block, 8);
+    memcpy(&hi, block + 8, 8);
+
+    if ((lo & 0x7F) != 0x40) {
+        memset(out, 0, 64);
+        return;
+    }
+
+    // bit layout: mode(7) R0 R1 G0 G1 B0 B1 A0 A1 (7 bits each) P0 P1,
+    // then indices with 3 bits for the first one and 4 for the others
+    auto bits = [&](int offset, int count) -> uint32_t {
+        uint64_t value;
+        if (offset >= 64) {
+            value = hi >> (offset - 64);
+        } else if (offset + count <= 64) {
+            value = lo >> offset;
+        } else {
+            value = (lo >> offset) | (hi << (64 - offset));
+        }
+        return uint32_t(value & ((1u << count) - 1));
+    };
+
+    uint32_t p0 = bits(63, 1);
+    uint32_t p1 = bits(64, 1);
+    uint8_t endpoints[2][4];
+    for (int c = 0; c < 4; c++) {
+        endpoints[0][c] = uint8_t((bits(7 + c * 14, 7) << 1) | p0);
+        endpoints[1][c] = uint8_t((bits(14 + c * 14, 7) << 1) | p1);
+    }
+
+    int offset = 65;
+    for (int i = 0; i < 16; i++) {
+        int count = i == 0 ? 3 : 4;
+        uint32_t weight = GTEX_BC7_WEIGHTS4[bits(offset, count)];
+        offset += count;
+        for (int c = 0; c < 4; c++) {
+            out[i * 4 + c] = uint8_t(((64 - weight) * endpoints[0][c] +
+                                      weight * endpoints[1][c] + 32) >>
+                                     6);
+        }
+    }
+}
+
+// decodes a whole block compressed level of `w` x `h` pixels into RGBA8
+inline void gtexDecodeLevel(GTexFormat format, const uint8_t* blocks,
+                            uint32_t w, uint32_t h, uint8_t* rgba) {
+    uint32_t block_size = gtexBlockSize(format);
+    uint32_t blocks_x = (w + 3) / 4;
+    uint32_t blocks_y = (h + 3) / 4;
+    for (uint32_t by = 0; by < blocks_y; by++) {
+        for (uint32_t bx = 0; bx < blocks_x; bx++) {
+            const uint8_t* block =
+                blocks + (size_t(by) * blocks_x + bx) * block_size;
+            uint8_t pixels[64];
+            if (format == GTexFormat::BC1) {
+                gtexDecodeBC1Block(block, pixels);
+            } else {
+                gtexDecodeBC7Block(block, pixels);
+            }
+
+            // blocks hanging over the border are cut off
+            for (uint32_t y = 0; y < 4 && by * 4 + y < h; y++) {
+                uint32_t count = w - bx * 4 < 4 ? w - bx * 4 : 4;
+                memcpy(rgba + ((size_t(by) * 4 + y) * w + bx * 4) * 4,
+                       pixels + y * 16, count * 4);
+            }
+        }
+    }
+}
@@ -1,2 +1,57 @@
+#include "stb_image_sink.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct StbiSink {
+    unsigned char* ptr;
+    size_t size;
+    bool taken;
+};
+
+static thread_local StbiSink gStbiSink;
+
+static void* stbiSinkMalloc(size_t size) {
+    if (gStbiSink.ptr && !gStbiSink.taken && size == gStbiSink.size) {
+        gStbiSink.taken = true;
+        return gStbiSink.ptr;
+    }
+    return malloc(size);
+}
+
+static void* stbiSinkRealloc(void* p, size_t size) {
+    if (p && p == gStbiSink.ptr) {
+        // stb wants to grow the buffer, move it to the heap
+        void* heap = malloc(size);
+        if (heap) {
+            memcpy(heap, p, size < gStbiSink.size ? size : gStbiSink.size);
+            gStbiSink.taken = false;
+        }
+        return heap;
+    }
+    return realloc(p, size);
+}
+
+static void stbiSinkFree(void* p) {
+    if (p && p == gStbiSink.ptr) {
+        gStbiSink.taken = false;
+        return;
+    }
+    free(p);
+}
+
+void stbi_sink_begin(void* dst, size_t size) {
+    gStbiSink.ptr = static_cast<unsigned char*>(dst);
+    gStbiSink.size = size;
+    gStbiSink.taken = false;
+}
+
+void stbi_sink_end() {
+    gStbiSink = StbiSink{};
+}
+
+#define STBI_MALLOC(sz) stbiSinkMalloc(sz)
+#define STBI_REALLOC(p, newsz) stbiSinkRealloc(p, newsz)
+#define STBI_FREE(p) stbiSinkFree(p)
+
 #define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
\ No newline at end of file
+#include "stb_image.h"
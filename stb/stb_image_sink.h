@@ -0,0 +1,12 @@
+#pragma once
+#include <stddef.h>
+
+// Lets the next stbi_load_* call on this thread decode its output straight
+// into `dst`, which must be `size` bytes (width * height * req_comp). stb
+// hands the pixels out through an allocation of exactly that size, so we
+// give it `dst` for that allocation instead of heap memory.
+//
+// The load returns `dst` on success. Decoders with an extra conversion step
+// can still return a heap buffer, callers must copy and free it then.
+void stbi_sink_begin(void* dst, size_t size);
+void stbi_sink_end();
@@ -0,0 +1,50 @@
+// Reflects a SPIR-V shader and writes the resource counts and vertex inputs
+// SDL needs into a `.meta` sidecar (see shader_meta.hpp).
+//
+// usage: shader_reflect <input .spv> <output .meta>
+#include "spirv_reflect.hpp"
+#include <cstdio>
+#include <vector>
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <input .spv> <output .meta>\n", argv[0]);
+        return 1;
+    }
+    const char* input = argv[1];
+    const char* output = argv[2];
+
+    FILE* file = fopen(input, "rb");
+    if (!file) {
+        fprintf(stderr, "can't open %s\n", input);
+        return 1;
+    }
+    std::vector<uint32_t> words;
+    uint32_t buffer[1024];
+    size_t count;
+    while ((count = fread(buffer, sizeof(uint32_t), 1024, file)) > 0) {
+        words.insert(words.end(), buffer, buffer + count);
+    }
+    fclose(file);
+
+    ShaderMeta meta;
+    std::string error;
+    if (!reflectSpirv(words.data(), words.size(), &meta, &error)) {
+        fprintf(stderr, "%s: %s\n", input, error.c_str());
+        return 1;
+    }
+
+    std::string text = shaderMetaWrite(meta);
+    file = fopen(output, "wb");
+    if (!file) {
+        fprintf(stderr, "can't open %s for writing\n", output);
+        return 1;
+    }
+    fwrite(text.data(), 1, text.size(), file);
+    bool ok = !ferror(file);
+    fclose(file);
+    if (!ok) {
+        fprintf(stderr, "write %s failed\n", output);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Resource counts and vertex inputs of a compiled shader, written into the
+// build directory by `shader_reflect` as `<name>.spv.meta` so the loader
+// doesn't need hand-typed numbers. The file is plain text, one entry per line:
+//
+//   stage vertex
+//   samplers 0
+//   storage_textures 0
+//   storage_buffers 1
+//   uniform_buffers 1
+//   input 0 float 3
+//
+// `input <location> <float|int|uint> <components>` only appears for vertex
+// shaders, sorted by location.
+
+enum class ShaderMetaStage : uint32_t { Vertex, Fragment };
+
+enum class ShaderMetaType : uint32_t { Float, Int, Uint };
+
+struct ShaderMetaInput {
+    uint32_t location{};
+    ShaderMetaType type = ShaderMetaType::Float;
+    uint32_t components{};
+};
+
+struct ShaderMeta {
+    ShaderMetaStage stage = ShaderMetaStage::Vertex;
+    uint32_t numSamplers{};
+    uint32_t numStorageTextures{};
+    uint32_t numStorageBuffers{};
+    uint32_t numUniformBuffers{};
+    std::vector<ShaderMetaInput> inputs;
+};
+
+inline const char* shaderMetaTypeName(ShaderMetaType type) {
+    switch (type) {
+        case ShaderMetaType::Int:
+            return "int";
+        case ShaderMetaType::Uint:
+            return "uint";
+        default:
+            return "float";
+    }
+}
+
+inline std::string shaderMetaWrite(const ShaderMeta& meta) {
+    std::string text;
+    char line[64];
+    snprintf(line, sizeof(line), "stage %s\n",
+             meta.stage == ShaderMetaStage::Vertex ? "vertex" : "fragment");
+    text += line;
+    snprintf(line, sizeof(line), "samplers %u\n", meta.numSamplers);
+    text += line;
+    snprintf(line, sizeof(line), "storage_textures %u\n",
+             meta.numStorageTextures);
+    text += line;
+    snprintf(line, sizeof(line), "storage_buffers %u\n",
+             meta.numStorageBuffers);
+    text += line;
+    snprintf(line, sizeof(line), "uniform_buffers %u\n",
+             meta.numUniformBuffers);
+    text += line;
+    for (auto& input : meta.inputs) {
+        snprintf(line, sizeof(line), "input %u %s %u\n", input.location,
+                 shaderMetaTypeName(input.type), input.components);
+        text += line;
+    }
+    return text;
+}
+
+// `text` doesn't need to be null terminated, unknown keys are skipped
+inline bool shaderMetaParse(const char* text, size_t size, ShaderMeta* out) {
+    *out = {};
+    std::string line;
+    size_t begin = 0;
+    while (begin < size) {
+        size_t end = begin;
+        while (end < size && text[end] != '\n') {
+            end++;
+        }
+        line.assign(text + begin, end - begin);
+        begin = end + 1;
+
+        char key[32];
+        char name[16];
+        unsigned a, b;
+        if (sscanf(line.c_str(), "%31s", key) != 1) {
+            continue;
+        }
+        if (strcmp(key, "stage") == 0) {
+            if (sscanf(line.c_str(), "%*s %15s", name) != 1) {
+                return false;
+            }
+            if (strcmp(name, "vertex") == 0) {
+                out->stage = ShaderMetaStage::Vertex;
+            } else if (strcmp(name, "fragment") == 0) {
+                out->stage = ShaderMetaStage::Fragment;
+            } else {
+                return false;
+            }
+        } else if (strcmp(key, "input") == 0) {
+            if (sscanf(line.c_str(), "%*s %u %15s %u", &a, name, &b) != 3 ||
+                b < 1 || b > 4) {
+                return false;
+            }
+            ShaderMetaInput input;
+            input.location = a;
+            input.components = b;
+            if (strcmp(name, "float") == 0) {
+                input.type = ShaderMetaType::Float;
+            } else if (strcmp(name, "int") == 0) {
+                input.type = ShaderMetaType::Int;
+            } else if (strcmp(name, "uint") == 0) {
+                input.type = ShaderMetaType::Uint;
+            } else {
+                return false;
+            }
+            out->inputs.push_back(input);
+        } else {
+            uint32_t* count = nullptr;
+            if (strcmp(key, "samplers") == 0) {
+                count = &out->numSamplers;
+            } else if (strcmp(key, "storage_textures") == 0) {
+                count = &out->numStorageTextures;
+            } else if (strcmp(key, "storage_buffers") == 0) {
+                count = &out->numStorageBuffers;
+            } else if (strcmp(key, "uniform_buffers") == 0) {
+                count = &out->numUniformBuffers;
+            }
+            if (count && sscanf(line.c_str(), "%*s %u", &a) == 1) {
+                *count = a;
+            } else if (count) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,302 @@
+#include "spirv_reflect.hpp"
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+
+constexpr uint32_t SpirvMagic = 0x07230203;
+constexpr size_t SpirvHeaderWords = 5;
+
+// opcodes
+constexpr uint32_t OpEntryPoint = 15;
+constexpr uint32_t OpTypeInt = 21;
+constexpr uint32_t OpTypeFloat = 22;
+constexpr uint32_t OpTypeVector = 23;
+constexpr uint32_t OpTypeImage = 25;
+constexpr uint32_t OpTypeSampler = 26;
+constexpr uint32_t OpTypeSampledImage = 27;
+constexpr uint32_t OpTypeArray = 28;
+constexpr uint32_t OpTypeRuntimeArray = 29;
+constexpr uint32_t OpTypeStruct = 30;
+constexpr uint32_t OpTypePointer = 32;
+constexpr uint32_t OpConstant = 43;
+constexpr uint32_t OpVariable = 59;
+constexpr uint32_t OpDecorate = 71;
+
+// decorations
+constexpr uint32_t DecorationBlock = 2;
+constexpr uint32_t DecorationBufferBlock = 3;
+constexpr uint32_t DecorationBuiltIn = 11;
+constexpr uint32_t DecorationLocation = 30;
+constexpr uint32_t DecorationBinding = 33;
+constexpr uint32_t DecorationDescriptorSet = 34;
+
+// storage classes
+constexpr uint32_t StorageUniformConstant = 0;
+constexpr uint32_t StorageInput = 1;
+constexpr uint32_t StorageUniform = 2;
+constexpr uint32_t StorageStorageBuffer = 12;
+
+// execution models
+constexpr uint32_t ExecutionVertex = 0;
+constexpr uint32_t ExecutionFragment = 4;
+
+struct Type {
+    uint32_t opcode{};
+    // element/component/pointee type
+    uint32_t element{};
+    // vector size, array length constant, int signedness
+    uint32_t count{};
+    // pointer storage class, image `sampled` operand
+    uint32_t storage{};
+};
+
+struct Decorations {
+    bool block = false;
+    bool bufferBlock = false;
+    bool builtIn = false;
+    uint32_t location = ~0u;
+    uint32_t binding = ~0u;
+    uint32_t set = ~0u;
+};
+
+struct Variable {
+    uint32_t id;
+    uint32_t type;
+    uint32_t storage;
+};
+
+enum ResourceKind { Sampler, StorageTexture, StorageBuffer, UniformBuffer };
+
+}  // namespace
+
+bool reflectSpirv(const uint32_t* words, size_t word_count, ShaderMeta* out,
+                  std::string* error) {
+    if (word_count < SpirvHeaderWords || words[0] != SpirvMagic) {
+        *error = "not a SPIR-V module";
+        return false;
+    }
+
+    std::unordered_map<uint32_t, Type> types;
+    std::unordered_map<uint32_t, uint32_t> constants;
+    std::unordered_map<uint32_t, Decorations> decorations;
+    std::vector<Variable> variables;
+    bool has_entry_point = false;
+    uint32_t execution_model = 0;
+
+    size_t i = SpirvHeaderWords;
+    while (i < word_count) {
+        uint32_t opcode = words[i] & 0xFFFF;
+        uint32_t length = words[i] >> 16;
+        if (length == 0 || i + length > word_count) {
+            *error = "truncated instruction";
+            return false;
+        }
+        const uint32_t* op = words + i;
+
+        switch (opcode) {
+            case OpEntryPoint:
+                // the first entry point is the one SDL uses ("main")
+                if (!has_entry_point) {
+                    has_entry_point = true;
+                    execution_model = op[1];
+                }
+                break;
+            case OpDecorate: {
+                Decorations& d = decorations[op[1]];
+                uint32_t value = length > 3 ? op[3] : 0;
+                switch (op[2]) {
+                    case DecorationBlock:
+                        d.block = true;
+                        break;
+                    case DecorationBufferBlock:
+                        d.bufferBlock = true;
+                        break;
+                    case DecorationBuiltIn:
+                        d.builtIn = true;
+                        break;
+                    case DecorationLocation:
+                        d.location = value;
+                        break;
+                    case DecorationBinding:
+                        d.binding = value;
+                        break;
+                    case DecorationDescriptorSet:
+                        d.set = value;
+                        break;
+                }
+                break;
+            }
+            case OpTypeInt:
+                types[op[1]] = {opcode, 0, op[3], 0};
+                break;
+            case OpTypeFloat:
+            case OpTypeSampler:
+            case OpTypeStruct:
+                types[op[1]] = {opcode, 0, 0, 0};
+                break;
+            case OpTypeVector:
+                types[op[1]] = {opcode, op[2], op[3], 0};
+                break;
+            case OpTypeImage:
+                types[op[1]] = {opcode, op[2], 0, op[7]};
+                break;
+            case OpTypeSampledImage:
+            case OpTypeRuntimeArray:
+                types[op[1]] = {opcode, op[2], 1, 0};
+                break;
+            case OpTypeArray:
+                types[op[1]] = {opcode, op[2], op[3], 0};
+                break;
+            case OpTypePointer:
+                types[op[1]] = {opcode, op[3], 0, op[2]};
+                break;
+            case OpConstant:
+                if (length > 3) {
+                    constants[op[2]] = op[3];
+                }
+                break;
+            case OpVariable:
+                variables.push_back({op[2], op[1], op[3]});
+                break;
+        }
+        i += length;
+    }
+
+    if (!has_entry_point) {
+        *error = "no entry point";
+        return false;
+    }
+    if (execution_model == ExecutionVertex) {
+        out->stage = ShaderMetaStage::Vertex;
+    } else if (execution_model == ExecutionFragment) {
+        out->stage = ShaderMetaStage::Fragment;
+    } else {
+        *error = "only vertex and fragment shaders are supported";
+        return false;
+    }
+    bool vertex = out->stage == ShaderMetaStage::Vertex;
+    uint32_t resource_set = vertex ? 0 : 2;
+    uint32_t uniform_set = vertex ? 1 : 3;
+
+    struct Binding {
+        uint32_t set;
+        uint32_t binding;
+        uint32_t size;
+        ResourceKind kind;
+    };
+    std::vector<Binding> bindings;
+    // lookups may insert, so types and decorations are copied out of the
+    // maps instead of referenced
+    for (auto& variable : variables) {
+        Decorations var_decorations = decorations[variable.id];
+        uint32_t type_id = types[variable.type].element;
+
+        if (variable.storage == StorageInput) {
+            if (!vertex || var_decorations.builtIn) {
+                continue;
+            }
+            Type type = types[type_id];
+            Type scalar = type.opcode == OpTypeVector ? types[type.element]
+                                                      : type;
+            ShaderMetaInput input;
+            input.location = var_decorations.location;
+            input.components = type.opcode == OpTypeVector ? type.count : 1;
+            if (scalar.opcode == OpTypeFloat) {
+                input.type = ShaderMetaType::Float;
+            } else if (scalar.opcode == OpTypeInt) {
+                input.type =
+                    scalar.count ? ShaderMetaType::Int : ShaderMetaType::Uint;
+            } else {
+                *error = "vertex inputs must be scalars or vectors";
+                return false;
+            }
+            out->inputs.push_back(input);
+            continue;
+        }
+
+        // arrays of resources take one binding per element
+        uint32_t array_size = 1;
+        while (types[type_id].opcode == OpTypeArray) {
+            array_size *= constants[types[type_id].count];
+            type_id = types[type_id].element;
+        }
+        Type type = types[type_id];
+
+        ResourceKind kind;
+        if (variable.storage == StorageUniformConstant) {
+            if (type.opcode == OpTypeSampledImage ||
+                type.opcode == OpTypeSampler) {
+                kind = Sampler;
+            } else if (type.opcode == OpTypeImage) {
+                // `sampled` 2 means read/write without a sampler
+                kind = type.storage == 2 ? StorageTexture : Sampler;
+            } else {
+                continue;
+            }
+        } else if (variable.storage == StorageStorageBuffer) {
+            kind = StorageBuffer;
+        } else if (variable.storage == StorageUniform) {
+            // before SPIR-V 1.3 storage buffers are uniforms with a
+            // BufferBlock struct
+            kind = decorations[type_id].bufferBlock ? StorageBuffer
+                                                    : UniformBuffer;
+        } else {
+            continue;
+        }
+
+        uint32_t expected_set = kind == UniformBuffer ? uniform_set
+                                                      : resource_set;
+        if (var_decorations.set != expected_set ||
+            var_decorations.binding == ~0u) {
+            *error = "resource with binding " +
+                     std::to_string(var_decorations.binding) + " is in set " +
+                     std::to_string(var_decorations.set) + ", SDL expects set " +
+                     std::to_string(expected_set);
+            return false;
+        }
+        bindings.push_back(
+            {var_decorations.set, var_decorations.binding, array_size, kind});
+    }
+
+    // within a set SDL binds sampled textures, then storage textures, then
+    // storage buffers, all packed from binding 0
+    std::sort(bindings.begin(), bindings.end(),
+              [](const Binding& a, const Binding& b) {
+                  return a.set != b.set ? a.set < b.set
+                                        : a.binding < b.binding;
+              });
+    uint32_t counts[4]{};
+    uint32_t next_binding[4]{};
+    for (size_t b = 0; b < bindings.size(); b++) {
+        const Binding& binding = bindings[b];
+        if (b > 0 && binding.set == bindings[b - 1].set &&
+            binding.kind < bindings[b - 1].kind) {
+            *error = "binding " + std::to_string(binding.binding) + " in set " +
+                     std::to_string(binding.set) +
+                     " breaks the sampler, storage texture, storage buffer "
+                     "order";
+            return false;
+        }
+        uint32_t& next = next_binding[binding.set];
+        if (binding.binding != next) {
+            *error = "bindings in set " + std::to_string(binding.set) +
+                     " must be packed from 0, expected binding " +
+                     std::to_string(next) + " but found " +
+                     std::to_string(binding.binding);
+            return false;
+        }
+        next += binding.size;
+        counts[binding.kind] += binding.size;
+    }
+
+    out->numSamplers = counts[Sampler];
+    out->numStorageTextures = counts[StorageTexture];
+    out->numStorageBuffers = counts[StorageBuffer];
+    out->numUniformBuffers = counts[UniformBuffer];
+    std::sort(out->inputs.begin(), out->inputs.end(),
+              [](const ShaderMetaInput& a, const ShaderMetaInput& b) {
+                  return a.location < b.location;
+              });
+    return true;
+}
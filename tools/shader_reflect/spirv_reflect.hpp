@@ -0,0 +1,13 @@
+#pragma once
+#include "shader_meta.hpp"
+#include <cstdint>
+#include <string>
+
+// Walks the declarations of a SPIR-V module and counts its resources the way
+// SDL_GPUShaderCreateInfo wants them. SDL expects fixed descriptor sets:
+// vertex shaders use set 0 for sampled textures, storage textures and
+// storage buffers and set 1 for uniform buffers, fragment shaders sets 2 and
+// 3. Resources in any other set are reported as an error, since SDL would
+// never bind them.
+bool reflectSpirv(const uint32_t* words, size_t word_count, ShaderMeta* out,
+                  std::string* error);
@@ -0,0 +1,291 @@
+#include "bc_encoder.hpp"
+#include "gtex_bc.hpp"
+#include <algorithm>
+#include <cmath>
+
+// mean and principal axis of the block's colors, `channels` is 3 or 4
+static void principalAxis(const uint8_t pixels[64], int channels,
+                          float mean[4], float axis[4]) {
+    for (int c = 0; c < 4; c++) {
+        mean[c] = 0;
+    }
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < channels; c++) {
+            mean[c] += pixels[i * 4 + c] / 16.0f;
+        }
+    }
+
+    float cov[4][4]{};
+    for (int i = 0; i < 16; i++) {
+        float d[4];
+        for (int c = 0; c < channels; c++) {
+            d[c] = pixels[i * 4 + c] - mean[c];
+        }
+        for (int a = 0; a < channels; a++) {
+            for (int b = 0; b < channels; b++) {
+                cov[a][b] += d[a] * d[b];
+            }
+        }
+    }
+
+    // power iteration, starting from the luminance-ish diagonal
+    for (int c = 0; c < 4; c++) {
+        axis[c] = c < channels ? 1.0f : 0.0f;
+    }
+    for (int iter = 0; iter < 8; iter++) {
+        float next[4]{};
+        for (int a = 0; a < channels; a++) {
+            for (int b = 0; b < channels; b++) {
+                next[a] += cov[a][b] * axis[b];
+            }
+        }
+        float len = 0;
+        for (int c = 0; c < channels; c++) {
+            len += next[c] * next[c];
+        }
+        if (len < 1e-6f) {
+            // flat block
+            break;
+        }
+        len = std::sqrt(len);
+        for (int c = 0; c < channels; c++) {
+            axis[c] = next[c] / len;
+        }
+    }
+}
+
+// endpoints where the block's projection onto its principal axis starts and
+// ends
+static void axisEndpoints(const uint8_t pixels[64], int channels,
+                          float e0[4], float e1[4]) {
+    float mean[4], axis[4];
+    principalAxis(pixels, channels, mean, axis);
+
+    float tmin = 0, tmax = 0;
+    for (int i = 0; i < 16; i++) {
+        float t = 0;
+        for (int c = 0; c < channels; c++) {
+            t += (pixels[i * 4 + c] - mean[c]) * axis[c];
+        }
+        tmin = std::min(tmin, t);
+        tmax = std::max(tmax, t);
+    }
+
+    for (int c = 0; c < 4; c++) {
+        e0[c] = std::clamp(mean[c] + axis[c] * tmin, 0.0f, 255.0f);
+        e1[c] = std::clamp(mean[c] + axis[c] * tmax, 0.0f, 255.0f);
+    }
+}
+
+static int colorDistance(const uint8_t* a, const uint8_t* b, int channels) {
+    int dist = 0;
+    for (int c = 0; c < channels; c++) {
+        int d = int(a[c]) - int(b[c]);
+        dist += d * d;
+    }
+    return dist;
+}
+
+static uint16_t pack565(const float color[4]) {
+    int r = std::clamp(int(color[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+    int g = std::clamp(int(color[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+    int b = std::clamp(int(color[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+    return uint16_t((r << 11) | (g << 5) | b);
+}
+
+void encodeBC1Block(const uint8_t pixels[64], uint8_t out[8]) {
+    float e0[4], e1[4];
+    axisEndpoints(pixels, 3, e0, e1);
+
+    uint16_t c0 = pack565(e1);
+    uint16_t c1 = pack565(e0);
+    // c0 > c1 selects the 4 color mode
+    if (c0 < c1) {
+        std::swap(c0, c1);
+    }
+
+    uint32_t indices = 0;
+    if (c0 != c1) {
+        // decode the quantized palette so indices match what the GPU sees
+        uint8_t block[8] = {uint8_t(c0), uint8_t(c0 >> 8), uint8_t(c1),
+                            uint8_t(c1 >> 8), 0xE4, 0xE4, 0xE4, 0xE4};
+        uint8_t palette[64];
+        gtexDecodeBC1Block(block, palette);
+
+        for (int i = 0; i < 16; i++) {
+            int best = 0;
+            int best_dist = colorDistance(pixels + i * 4, palette, 3);
+            for (int p = 1; p < 4; p++) {
+                int dist = colorDistance(pixels + i * 4, palette + p * 4, 3);
+                if (dist < best_dist) {
+                    best = p;
+                    best_dist = dist;
+                }
+            }
+            indices |= uint32_t(best) << (i * 2);
+        }
+    }
+
+    out[0] = uint8_t(c0);
+    out[1] = uint8_t(c0 >> 8);
+    out[2] = uint8_t(c1);
+    out[3] = uint8_t(c1 >> 8);
+    out[4] = uint8_t(indices);
+    out[5] = uint8_t(indices >> 8);
+    out[6] = uint8_t(indices >> 16);
+    out[7] = uint8_t(indices >> 24);
+}
+
+struct BC7Endpoints {
+    uint8_t color[2][4];
+    uint8_t pbit[2];
+};
+
+// 7 bit per channel plus a shared p-bit, pick the p-bit with less error
+static void quantizeBC7Endpoint(const float value[4], uint8_t color[4],
+                                uint8_t* pbit) {
+    float best_error = -1;
+    for (int p = 0; p < 2; p++) {
+        uint8_t q[4];
+        float error = 0;
+        for (int c = 0; c < 4; c++) {
+            q[c] = uint8_t(std::clamp(int((value[c] - p) / 2.0f + 0.5f), 0, 127));
+            float d = float((q[c] << 1) | p) - value[c];
+            error += d * d;
+        }
+        if (best_error < 0 || error < best_error) {
+            best_error = error;
+            memcpy(color, q, 4);
+            *pbit = uint8_t(p);
+        }
+    }
+}
+
+static void unpackBC7Endpoint(const BC7Endpoints& e, int i, uint8_t out[4]) {
+    for (int c = 0; c < 4; c++) {
+        out[c] = uint8_t((e.color[i][c] << 1) | e.pbit[i]);
+    }
+}
+
+// best index per pixel for the given endpoints, returns the total error
+static int bc7Indices(const uint8_t pixels[64], const BC7Endpoints& e,
+                      uint8_t indices[16]) {
+    uint8_t ep[2][4];
+    unpackBC7Endpoint(e, 0, ep[0]);
+    unpackBC7Endpoint(e, 1, ep[1]);
+
+    uint8_t palette[16][4];
+    for (int i = 0; i < 16; i++) {
+        uint32_t w = GTEX_BC7_WEIGHTS4[i];
+        for (int c = 0; c < 4; c++) {
+            palette[i][c] =
+                uint8_t(((64 - w) * ep[0][c] + w * ep[1][c] + 32) >> 6);
+        }
+    }
+
+    int total = 0;
+    for (int i = 0; i < 16; i++) {
+        int best = 0;
+        int best_dist = colorDistance(pixels + i * 4, palette[0], 4);
+        for (int p = 1; p < 16; p++) {
+            int dist = colorDistance(pixels + i * 4, palette[p], 4);
+            if (dist < best_dist) {
+                best = p;
+                best_dist = dist;
+            }
+        }
+        indices[i] = uint8_t(best);
+        total += best_dist;
+    }
+    return total;
+}
+
+// least squares endpoints for fixed indices, false if the indices don't
+// determine them (all pixels use the same weight)
+static bool refineBC7Endpoints(const uint8_t pixels[64],
+                               const uint8_t indices[16], float e0[4],
+                               float e1[4]) {
+    float aa = 0, ab = 0, bb = 0;
+    float ax[4]{}, bx[4]{};
+    for (int i = 0; i < 16; i++) {
+        float b = GTEX_BC7_WEIGHTS4[indices[i]] / 64.0f;
+        float a = 1.0f - b;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (int c = 0; c < 4; c++) {
+            ax[c] += a * pixels[i * 4 + c];
+            bx[c] += b * pixels[i * 4 + c];
+        }
+    }
+
+    float det = aa * bb - ab * ab;
+    if (std::fabs(det) < 1e-6f) {
+        return false;
+    }
+    for (int c = 0; c < 4; c++) {
+        e0[c] = std::clamp((bb * ax[c] - ab * bx[c]) / det, 0.0f, 255.0f);
+        e1[c] = std::clamp((aa * bx[c] - ab * ax[c]) / det, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+struct BitWriter {
+    uint8_t* out;
+    int offset = 0;
+
+    void Write(uint32_t value, int count) {
+        for (int i = 0; i < count; i++, offset++) {
+            if (value & (1u << i)) {
+                out[offset / 8] |= uint8_t(1u << (offset % 8));
+            }
+        }
+    }
+};
+
+void encodeBC7Block(const uint8_t pixels[64], uint8_t out[16]) {
+    float e0[4], e1[4];
+    axisEndpoints(pixels, 4, e0, e1);
+
+    BC7Endpoints endpoints;
+    quantizeBC7Endpoint(e0, endpoints.color[0], &endpoints.pbit[0]);
+    quantizeBC7Endpoint(e1, endpoints.color[1], &endpoints.pbit[1]);
+    uint8_t indices[16];
+    int error = bc7Indices(pixels, endpoints, indices);
+
+    // one least squares pass, keep it only if it helped
+    if (refineBC7Endpoints(pixels, indices, e0, e1)) {
+        BC7Endpoints refined;
+        quantizeBC7Endpoint(e0, refined.color[0], &refined.pbit[0]);
+        quantizeBC7Endpoint(e1, refined.color[1], &refined.pbit[1]);
+        uint8_t refined_indices[16];
+        if (bc7Indices(pixels, refined, refined_indices) < error) {
+            endpoints = refined;
+            memcpy(indices, refined_indices, sizeof(indices));
+        }
+    }
+
+    // the first index is stored with 3 bits, so its top bit must be 0
+    if (indices[0] & 8) {
+        for (int c = 0; c < 4; c++) {
+            std::swap(endpoints.color[0][c], endpoints.color[1][c]);
+        }
+        std::swap(endpoints.pbit[0], endpoints.pbit[1]);
+        for (int i = 0; i < 16; i++) {
+            indices[i] = uint8_t(15 - indices[i]);
+        }
+    }
+
+    memset(out, 0, 16);
+    BitWriter writer{out};
+    writer.Write(1 << 6, 7);
+    for (int c = 0; c < 4; c++) {
+        writer.Write(endpoints.color[0][c], 7);
+        writer.Write(endpoints.color[1][c], 7);
+    }
+    writer.Write(endpoints.pbit[0], 1);
+    writer.Write(endpoints.pbit[1], 1);
+    for (int i = 0; i < 16; i++) {
+        writer.Write(indices[i], i == 0 ? 3 : 4);
+    }
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include <cstdint>
+
+// Block encoders for the cooker. `pixels` is one 4x4 block of RGBA8 pixels,
+// row by row.
+
+// 4 color mode only, alpha is ignored
+void encodeBC1Block(const uint8_t pixels[64], uint8_t out[8]);
+
+// mode 6 only: one RGBA line per block, good for smooth color and alpha but
+// blurrier than a full multi-mode encoder on sharp multi-color edges
+void encodeBC7Block(const uint8_t pixels[64], uint8_t out[16]);
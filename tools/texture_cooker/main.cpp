@@ -0,0 +1,189 @@
+// Converts an image into a `.gtex` container (see gtex/gtex.hpp) with the
+// whole mip chain precomputed, so loading it at runtime needs no decoding.
+//
+// usage: texture_cooker [--format auto|rgba8|bc1|bc7] <input image> <output .gtex>
+//
+// `auto` (the default) picks BC1 for opaque images and BC7 otherwise.
+#include "bc_encoder.hpp"
+#include "gtex.hpp"
+#include "stb_image.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+struct Image {
+    uint32_t width{};
+    uint32_t height{};
+    std::vector<uint8_t> pixels;
+};
+
+// 2x2 box filter, the last row/column is repeated for odd sizes
+Image downsample(const Image& src) {
+    Image dst;
+    dst.width = std::max(src.width / 2, 1u);
+    dst.height = std::max(src.height / 2, 1u);
+    dst.pixels.resize(size_t(dst.width) * dst.height * 4);
+
+    for (uint32_t y = 0; y < dst.height; y++) {
+        uint32_t y0 = std::min(y * 2, src.height - 1);
+        uint32_t y1 = std::min(y * 2 + 1, src.height - 1);
+        for (uint32_t x = 0; x < dst.width; x++) {
+            uint32_t x0 = std::min(x * 2, src.width - 1);
+            uint32_t x1 = std::min(x * 2 + 1, src.width - 1);
+            const uint8_t* p00 = &src.pixels[(size_t(y0) * src.width + x0) * 4];
+            const uint8_t* p01 = &src.pixels[(size_t(y0) * src.width + x1) * 4];
+            const uint8_t* p10 = &src.pixels[(size_t(y1) * src.width + x0) * 4];
+            const uint8_t* p11 = &src.pixels[(size_t(y1) * src.width + x1) * 4];
+            uint8_t* out = &dst.pixels[(size_t(y) * dst.width + x) * 4];
+            for (int c = 0; c < 4; c++) {
+                out[c] = uint8_t((p00[c] + p01[c] + p10[c] + p11[c] + 2) / 4);
+            }
+        }
+    }
+    return dst;
+}
+
+bool isOpaque(const Image& image) {
+    for (size_t i = 3; i < image.pixels.size(); i += 4) {
+        if (image.pixels[i] != 255) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// replaces the pixels with 4x4 blocks, edge pixels are repeated to fill the
+// blocks hanging over the right and bottom border
+void compress(Image& image, GTexFormat format) {
+    uint32_t block_size = gtexBlockSize(format);
+    uint32_t blocks_x = (image.width + 3) / 4;
+    uint32_t blocks_y = (image.height + 3) / 4;
+    std::vector<uint8_t> blocks(size_t(blocks_x) * blocks_y * block_size);
+
+    for (uint32_t by = 0; by < blocks_y; by++) {
+        for (uint32_t bx = 0; bx < blocks_x; bx++) {
+            uint8_t pixels[64];
+            for (uint32_t y = 0; y < 4; y++) {
+                uint32_t sy = std::min(by * 4 + y, image.height - 1);
+                for (uint32_t x = 0; x < 4; x++) {
+                    uint32_t sx = std::min(bx * 4 + x, image.width - 1);
+                    memcpy(pixels + (y * 4 + x) * 4,
+                           &image.pixels[(size_t(sy) * image.width + sx) * 4],
+                           4);
+                }
+            }
+
+            uint8_t* out =
+                &blocks[(size_t(by) * blocks_x + bx) * block_size];
+            if (format == GTexFormat::BC1) {
+                encodeBC1Block(pixels, out);
+            } else {
+                encodeBC7Block(pixels, out);
+            }
+        }
+    }
+    image.pixels = std::move(blocks);
+}
+
+bool writeContainer(const char* filename, GTexFormat format,
+                    const std::vector<Image>& levels) {
+    GTexHeader header{};
+    memcpy(header.magic, GTEX_MAGIC, sizeof(GTEX_MAGIC));
+    header.version = GTEX_VERSION;
+    header.format = format;
+    header.width = levels[0].width;
+    header.height = levels[0].height;
+    header.levelCount = static_cast<uint32_t>(levels.size());
+
+    std::vector<GTexLevel> level_table(levels.size());
+    uint64_t offset = sizeof(GTexHeader) + levels.size() * sizeof(GTexLevel);
+    for (size_t i = 0; i < levels.size(); i++) {
+        offset = (offset + GTEX_DATA_ALIGNMENT - 1) / GTEX_DATA_ALIGNMENT *
+                 GTEX_DATA_ALIGNMENT;
+        level_table[i].width = levels[i].width;
+        level_table[i].height = levels[i].height;
+        level_table[i].offset = offset;
+        level_table[i].size = levels[i].pixels.size();
+        offset += level_table[i].size;
+    }
+
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        fprintf(stderr, "can't open %s for writing\n", filename);
+        return false;
+    }
+
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(level_table.data(), sizeof(GTexLevel), level_table.size(), file);
+    const char zeros[GTEX_DATA_ALIGNMENT]{};
+    for (size_t i = 0; i < levels.size(); i++) {
+        long padding = static_cast<long>(level_table[i].offset) - ftell(file);
+        fwrite(zeros, 1, padding, file);
+        fwrite(levels[i].pixels.data(), 1, levels[i].pixels.size(), file);
+    }
+
+    bool ok = !ferror(file);
+    fclose(file);
+    if (!ok) {
+        fprintf(stderr, "write %s failed\n", filename);
+    }
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    const char* format_name = "auto";
+    int arg = 1;
+    if (argc == 5 && strcmp(argv[1], "--format") == 0) {
+        format_name = argv[2];
+        arg = 3;
+    } else if (argc != 3) {
+        fprintf(stderr,
+                "usage: %s [--format auto|rgba8|bc1|bc7] <input image> "
+                "<output .gtex>\n",
+                argv[0]);
+        return 1;
+    }
+    const char* input = argv[arg];
+    const char* output = argv[arg + 1];
+
+    int w, h;
+    stbi_uc* data = stbi_load(input, &w, &h, nullptr, STBI_rgb_alpha);
+    if (!data) {
+        fprintf(stderr, "load %s failed: %s\n", input, stbi_failure_reason());
+        return 1;
+    }
+
+    std::vector<Image> levels(1);
+    levels[0].width = w;
+    levels[0].height = h;
+    levels[0].pixels.assign(data, data + size_t(w) * h * 4);
+    stbi_image_free(data);
+
+    while (levels.back().width > 1 || levels.back().height > 1) {
+        levels.push_back(downsample(levels.back()));
+    }
+
+    GTexFormat format;
+    if (strcmp(format_name, "auto") == 0) {
+        format = isOpaque(levels[0]) ? GTexFormat::BC1 : GTexFormat::BC7;
+    } else if (strcmp(format_name, "rgba8") == 0) {
+        format = GTexFormat::RGBA8;
+    } else if (strcmp(format_name, "bc1") == 0) {
+        format = GTexFormat::BC1;
+    } else if (strcmp(format_name, "bc7") == 0) {
+        format = GTexFormat::BC7;
+    } else {
+        fprintf(stderr, "unknown format %s\n", format_name);
+        return 1;
+    }
+
+    // mips are filtered from the uncompressed levels, so compression errors
+    // don't add up along the chain
+    if (format != GTexFormat::RGBA8) {
+        for (auto& level : levels) {
+            compress(level, format);
+        }
+    }
+
+    return writeContainer(output, format, levels) ? 0 : 1;
+}